@@ -0,0 +1,88 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Арена с выделением сдвигом указателя (bump). Элементы лежат блоками по
+// 2^BLOCK_BITS и адресуются 32-битным индексом: номер блока в старших битах,
+// смещение - в младших. Блоки не перемещаются, поэтому рост арены не копирует
+// данные и указатели на элементы остаются действительными.
+// Несколько элементов, выделенных одним allocate, лежат подряд (срез больше
+// блока получает собственный блок и начинается в нём с нуля; смещение в
+// индексе не превосходит BLOCK_SIZE, поэтому в такой блок после среза ничего
+// не кладётся). Деструкторы не вызываются: T тривиален, clear() - O(1),
+// блоки переиспользуются.
+template <typename T, unsigned BLOCK_BITS = 16>
+class BumpArena {
+    static_assert(std::is_trivially_destructible<T>::value, "Элементы арены не должны требовать деструктора");
+
+public:
+    static const uint32_t BLOCK_SIZE = 1u << BLOCK_BITS;
+
+    BumpArena() : current(0), used(0), live(0) {}
+
+    // Место под count элементов подряд; возвращает индекс первого
+    uint32_t allocate(size_t count = 1) {
+        if (blocks.empty() || !fits(count)) nextBlock(count);
+        uint32_t index = static_cast<uint32_t>((current << BLOCK_BITS) | used);
+        used += count;
+        live += count;
+        return index;
+    }
+
+    // Элемент по индексу; элементы одного среза - at(index) + i
+    T* at(uint32_t index) {
+        return blocks[index >> BLOCK_BITS].data.get() + (index & (BLOCK_SIZE - 1));
+    }
+    const T* at(uint32_t index) const {
+        return blocks[index >> BLOCK_BITS].data.get() + (index & (BLOCK_SIZE - 1));
+    }
+
+    size_t count() const { return live; }                // Выделено элементов
+    size_t bytes() const { return live * sizeof(T); }    // Из них занято байт
+
+    void clear() {
+        current = 0;
+        used = 0;
+        live = 0;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<T[]> data;
+        size_t capacity;
+    };
+    std::vector<Block> blocks;
+    size_t current;  // Номер текущего блока
+    size_t used;     // Занято в текущем блоке
+    size_t live;
+
+    // Срез из count элементов помещается в текущий блок. Дальше BLOCK_SIZE
+    // заполняется только срез с начала блока: иначе смещение не уместится в
+    // младших битах индекса (большой блок мог остаться от среза до clear())
+    bool fits(size_t count) const {
+        size_t limit = used == 0 ? blocks[current].capacity : BLOCK_SIZE;
+        return used + count <= limit && used + count <= blocks[current].capacity;
+    }
+
+    // Переход к следующему блоку, в который поместится count элементов
+    void nextBlock(size_t count) {
+        size_t next = blocks.empty() ? 0 : current + 1;
+        if (next >= blocks.size() || blocks[next].capacity < count) {
+            if (next >= (size_t(1) << (32 - BLOCK_BITS))) {
+                throw std::runtime_error("Арена исчерпала 32-битные индексы.");
+            }
+            size_t capacity = count > BLOCK_SIZE ? count : BLOCK_SIZE;
+            blocks.insert(blocks.begin() + next, Block{std::unique_ptr<T[]>(new T[capacity]), capacity});
+        }
+        current = next;
+        used = 0;
+    }
+};
+
+#endif // ARENA_H
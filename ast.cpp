@@ -0,0 +1,183 @@
+#include "ast.h"
+#include "intern.h"
+#include "scanner.h"
+#include <stdexcept>
+
+Ast::Ast() : last(0), enabled(true) {
+}
+
+void Ast::clear() {
+    nodes.clear();
+    child_lists.clear();
+    floats.clear();
+    build_stack.clear();
+    last = 0;
+}
+
+void Ast::setEnabled(bool on) {
+    enabled = on;
+}
+
+size_t Ast::mark() const {
+    return build_stack.size();
+}
+
+void Ast::leaf(NodeKind kind, DataType type, SourceLoc loc, uint32_t data) {
+    if (!enabled) return;
+    last = nodes.allocate();
+    *nodes.at(last) = {kind, static_cast<uint8_t>(type), 0, 0, loc, 0, 0, data};
+    build_stack.push_back(last);
+}
+
+void Ast::node(NodeKind kind, DataType type, SourceLoc loc, size_t child_count,
+               uint32_t data, uint8_t op) {
+    if (!enabled) return;
+    size_t depth = build_stack.size();
+    if (child_count > depth) {
+        throw std::logic_error("Стек построения дерева короче числа детей узла");
+    }
+
+    // Дети - верхние child_count узлов стека, в порядке построения
+    uint32_t first = 0;
+    if (child_count > 0) {
+        first = child_lists.allocate(child_count);
+        NodeId* list = child_lists.at(first);
+        for (size_t i = 0; i < child_count; ++i) list[i] = build_stack[depth - child_count + i];
+        build_stack.resize(depth - child_count);
+    }
+
+    last = nodes.allocate();
+    *nodes.at(last) = {kind, static_cast<uint8_t>(type), op, 0, loc, first,
+                       static_cast<uint32_t>(child_count), data};
+    build_stack.push_back(last);
+}
+
+uint32_t Ast::addFloat(double value) {
+    if (!enabled) return 0;
+    floats.push_back(value);
+    return static_cast<uint32_t>(floats.size() - 1);
+}
+
+bool Ast::empty() const {
+    return nodes.count() == 0;
+}
+
+NodeId Ast::root() const {
+    return last;
+}
+
+size_t Ast::size() const {
+    return nodes.count();
+}
+
+const AstNode& Ast::at(NodeId id) const {
+    return *nodes.at(id);
+}
+
+NodeId Ast::child(const AstNode& node, size_t index) const {
+    return child_lists.at(node.children)[index];
+}
+
+double Ast::floatValue(uint32_t index) const {
+    return floats[index];
+}
+
+size_t Ast::memoryBytes() const {
+    return nodes.bytes() + child_lists.bytes() + floats.size() * sizeof(double);
+}
+
+// --- Вывод дерева ---
+
+namespace {
+
+const char* nodeKindName(uint8_t kind) {
+    switch (kind) {
+        case N_PROGRAM: return "Program";
+        case N_DATA: return "Data";
+        case N_VAR: return "Var";
+        case N_FUNCTION: return "Function";
+        case N_PARAM: return "Param";
+        case N_BLOCK: return "Block";
+        case N_ASSIGN: return "Assign";
+        case N_WHILE: return "While";
+        case N_CALL: return "Call";
+        case N_EMPTY: return "Empty";
+        case N_BINARY: return "Binary";
+        case N_UNARY: return "Unary";
+        case N_NAME: return "Name";
+        case N_INT_CONST: return "Int";
+        case N_FLOAT_CONST: return "Float";
+        case N_ERROR: return "Error";
+        default: return "?";
+    }
+}
+
+// Текст операции по типу лексемы
+const char* opSpelling(uint8_t op) {
+    switch (op) {
+        case T_BIT_OR: return "|";
+        case T_BIT_XOR: return "^";
+        case T_BIT_AND: return "&";
+        case T_EQ: return "==";
+        case T_NE: return "!=";
+        case T_LT: return "<";
+        case T_LE: return "<=";
+        case T_GT: return ">";
+        case T_GE: return ">=";
+        case T_LSHIFT: return "<<";
+        case T_RSHIFT: return ">>";
+        case T_PLUS: return "+";
+        case T_MINUS: return "-";
+        case T_MUL: return "*";
+        case T_DIV: return "/";
+        case T_MOD: return "%";
+        default: return "?";
+    }
+}
+
+} // namespace
+
+void Ast::print(std::ostream& out) const {
+    out << "\n--- Syntax Tree ---\n";
+    if (!empty()) printNode(out, root(), 0);
+    out << size() << " nodes, " << memoryBytes() << " bytes\n";
+    out << "-------------------\n";
+}
+
+// Обход в прямом порядке с явным стеком: глубина дерева не ограничена стеком потока
+void Ast::printNode(std::ostream& out, NodeId id, int depth) const {
+    std::vector<std::pair<NodeId, int>> pending{{id, depth}};
+    while (!pending.empty()) {
+        id = pending.back().first;
+        depth = pending.back().second;
+        pending.pop_back();
+        printLine(out, at(id), depth);
+        const AstNode& n = at(id);
+        for (uint32_t i = n.child_count; i > 0; --i) pending.push_back({child(n, i - 1), depth + 1});
+    }
+}
+
+void Ast::printLine(std::ostream& out, const AstNode& n, int depth) const {
+    for (int i = 0; i < depth; ++i) out << "  ";
+    out << nodeKindName(n.kind);
+    switch (n.kind) {
+        case N_VAR: case N_FUNCTION: case N_PARAM: case N_ASSIGN: case N_CALL: case N_NAME:
+            out << " " << atom_table.name(n.data);
+            break;
+        case N_BINARY: case N_UNARY:
+            out << " " << opSpelling(n.op);
+            break;
+        case N_INT_CONST:
+            out << " " << n.data;
+            break;
+        case N_FLOAT_CONST:
+            out << " " << floats[n.data];
+            break;
+        default:
+            break;
+    }
+    if (n.type != TYPE_UNDEFINED) {
+        out << " (" << SemanticAnalyzer::dataTypeToString(static_cast<DataType>(n.type)) << ")";
+    }
+    out << "\n";
+}
@@ -0,0 +1,97 @@
+#ifndef AST_H
+#define AST_H
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "arena.h"
+#include "location.h"
+#include "semantic.h"
+
+// Номер узла синтаксического дерева (индекс в массиве узлов)
+typedef uint32_t NodeId;
+
+enum NodeKind : uint8_t {
+    N_PROGRAM,     // Дети: описания верхнего уровня
+    N_DATA,        // Описание данных; дети: N_VAR
+    N_VAR,         // Переменная (data - атом); ребёнок - инициализатор, если есть
+    N_FUNCTION,    // Функция (data - атом); дети: N_PARAM..., N_BLOCK
+    N_PARAM,       // Параметр (data - атом)
+    N_BLOCK,       // Составной оператор; дети: операторы
+    N_ASSIGN,      // Присваивание (data - атом переменной); ребёнок - выражение
+    N_WHILE,       // Цикл; дети: условие, тело
+    N_CALL,        // Вызов (data - атом функции); дети: аргументы
+    N_EMPTY,       // Пустой оператор ';'
+    N_BINARY,      // Бинарная операция op; дети: левый и правый операнды
+    N_UNARY,       // Унарная операция op; ребёнок - операнд
+    N_NAME,        // Имя в выражении (data - атом)
+    N_INT_CONST,   // Целая или символьная константа (data - значение, до 32 бит)
+    N_FLOAT_CONST, // Вещественная константа (data - индекс в пуле вещественных)
+    N_ERROR        // Место синтаксической ошибки; дети - то, что успели построить
+};
+
+// Узел - 20 байт: вид, тип, операция, позиция, срез детей и полезная нагрузка.
+// Номера детей узла лежат подряд в арене детей начиная с индекса children;
+// у листа (child_count = 0) children не используется.
+struct AstNode {
+    uint8_t kind;          // NodeKind
+    uint8_t type;          // DataType выражения / объявленный тип
+    uint8_t op;            // TokenType операции (N_BINARY, N_UNARY)
+    uint8_t reserved;
+    SourceLoc loc;
+    uint32_t children;
+    uint32_t child_count;
+    uint32_t data;         // Атом, значение или индекс константы (см. NodeKind)
+};
+
+static_assert(sizeof(AstNode) == 20, "Узел дерева должен занимать 20 байт");
+
+// Компактное синтаксическое дерево. Узлы и списки детей выделяются из арен
+// (BumpArena), ссылки между узлами - 32-битные индексы. Память на узел -
+// 20 байт плюс 4 байта на место в списке детей родителя. Деструкторов у узлов
+// нет: clear() освобождает всё дерево за O(1), оставляя блоки арен для
+// следующего разбора.
+//
+// Дерево строится снизу вверх: парсер кладёт готовые узлы на стек построения,
+// а родитель забирает с его вершины своих детей (node), поэтому узлы
+// нумеруются в обратном порядке обхода и корень создаётся последним.
+class Ast {
+public:
+    Ast();
+    void clear();
+    // Выключенное дерево не строится: leaf и node ничего не делают
+    // (однопроходная генерация кода, см. CodeEmitter)
+    void setEnabled(bool on);
+
+    // --- Построение ---
+    size_t mark() const;        // Глубина стека построения (для подсчёта детей)
+    void leaf(NodeKind kind, DataType type, SourceLoc loc, uint32_t data = 0);
+    // Узел, забирающий child_count верхних узлов стека построения
+    void node(NodeKind kind, DataType type, SourceLoc loc, size_t child_count,
+              uint32_t data = 0, uint8_t op = 0);
+    uint32_t addFloat(double value); // Индекс константы для N_FLOAT_CONST
+
+    // --- Чтение ---
+    bool empty() const;
+    NodeId root() const;        // Последний построенный узел (N_PROGRAM после разбора)
+    size_t size() const;
+    const AstNode& at(NodeId id) const;
+    NodeId child(const AstNode& node, size_t index) const;
+    double floatValue(uint32_t index) const;
+    size_t memoryBytes() const; // Занятая деревом память (без запаса ёмкости)
+
+    void print(std::ostream& out) const;
+
+private:
+    BumpArena<AstNode> nodes;
+    BumpArena<NodeId> child_lists;   // Срезы детей всех узлов
+    std::vector<double> floats;
+    std::vector<NodeId> build_stack;
+    NodeId last;                     // Последний построенный узел
+    bool enabled;
+
+    void printNode(std::ostream& out, NodeId id, int depth) const;
+    void printLine(std::ostream& out, const AstNode& n, int depth) const;
+};
+
+#endif // AST_H
@@ -0,0 +1,65 @@
+// Замер масштабирования параллельного лексического разбора:
+//   bench_lex.exe <filename> [max_threads]
+// Для 1, 2, 4, ... max_threads потоков строит буфер лексем, сверяет его
+// с последовательным разбором и печатает время, пропускную способность и ускорение.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include "source.h"
+#include "token_buffer.h"
+
+static bool sameTokens(const TokenBuffer& a, const TokenBuffer& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a.type(i) != b.type(i) || a.offset(i) != b.offset(i) || a.length(i) != b.length(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <filename> [max_threads]" << std::endl;
+        return 1;
+    }
+    unsigned max_threads = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 32;
+
+    SourceFile file;
+    if (!file.open(argv[1])) {
+        std::cerr << "Error: Could not open file " << argv[1] << std::endl;
+        return 1;
+    }
+    double megabytes = file.text().length() / (1024.0 * 1024.0);
+
+    const int REPEATS = 3; // Берётся лучшее время из нескольких прогонов
+    TokenBuffer reference(file.text(), 1);
+    double base_seconds = 0;
+
+    std::cout << "threads    time, ms      MB/s   speedup  resynced" << std::endl;
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        double best = 1e30;
+        size_t resynced = 0;
+        for (int r = 0; r < REPEATS; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            TokenBuffer tokens(file.text(), threads);
+            auto finish = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double>(finish - start).count());
+            resynced = tokens.getResyncedChunks();
+            if (!sameTokens(tokens, reference)) {
+                std::cerr << "Mismatch with sequential lexing at " << threads << " threads" << std::endl;
+                return 1;
+            }
+        }
+        if (threads == 1) base_seconds = best;
+        std::cout << std::setw(7) << threads
+                  << std::setw(12) << std::fixed << std::setprecision(2) << best * 1000
+                  << std::setw(10) << std::setprecision(1) << megabytes / best
+                  << std::setw(10) << std::setprecision(2) << base_seconds / best
+                  << std::setw(10) << resynced << std::endl;
+    }
+    std::cout << reference.size() << " tokens, " << std::setprecision(1) << megabytes << " MB" << std::endl;
+    return 0;
+}
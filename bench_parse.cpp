@@ -0,0 +1,86 @@
+// Сравнение двух способов синтаксического разбора на одних и тех же входах:
+//   bench_parse.exe <filename>...
+// Для каждого файла строит буфер лексем, разбирает его рекурсивным спуском и
+// по LL(1)-таблице (лучшее время из нескольких прогонов), печатает время,
+// пропускную способность и сверяет результаты: для программы без ошибок
+// вывод и синтаксическое дерево должны совпасть, для программы с ошибками -
+// хотя бы наличие ошибок (тексты синтаксических ошибок у способов разные).
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include "parser.h"
+#include "source.h"
+#include "token_buffer.h"
+
+namespace {
+
+struct EngineRun {
+    double seconds = 1e30;
+    std::string output; // Предупреждения и семантическое дерево
+    std::string tree;   // Синтаксическое дерево
+    size_t errors = 0;
+};
+
+EngineRun run(TokenBuffer& tokens, ParserEngine engine) {
+    const int REPEATS = 3; // Берётся лучшее время из нескольких прогонов
+    EngineRun result;
+    for (int r = 0; r < REPEATS; ++r) {
+        std::ostringstream captured;
+        std::streambuf* saved = std::cout.rdbuf(captured.rdbuf());
+        Parser parser(&tokens);
+        auto start = std::chrono::steady_clock::now();
+        parser.parse(engine);
+        auto finish = std::chrono::steady_clock::now();
+        std::cout.rdbuf(saved);
+
+        result.seconds = std::min(result.seconds, std::chrono::duration<double>(finish - start).count());
+        if (r == 0) {
+            result.output = captured.str();
+            std::ostringstream tree;
+            parser.getAst().print(tree);
+            result.tree = tree.str();
+            result.errors = parser.getDiagnostics().errorCount();
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <filename>..." << std::endl;
+        return 1;
+    }
+
+    bool all_match = true;
+    std::cout << "file                       tokens   recursive, ms   table, ms   table/recursive  errors  result" << std::endl;
+    for (int i = 1; i < argc; ++i) {
+        SourceFile file;
+        if (!file.open(argv[i])) {
+            std::cerr << "Error: Could not open file " << argv[i] << std::endl;
+            return 1;
+        }
+        TokenBuffer tokens(file.text());
+        EngineRun recursive = run(tokens, ENGINE_RECURSIVE);
+        EngineRun table = run(tokens, ENGINE_TABLE);
+
+        bool match = recursive.errors == 0
+                         ? table.errors == 0 && recursive.output == table.output && recursive.tree == table.tree
+                         : table.errors != 0;
+        all_match = all_match && match;
+
+        std::string name = argv[i];
+        if (name.size() > 24) name = "..." + name.substr(name.size() - 21);
+        std::cout << std::left << std::setw(24) << name << std::right
+                  << std::setw(10) << tokens.size()
+                  << std::setw(16) << std::fixed << std::setprecision(2) << recursive.seconds * 1000
+                  << std::setw(12) << table.seconds * 1000
+                  << std::setw(18) << table.seconds / recursive.seconds
+                  << std::setw(5) << recursive.errors << '/' << std::left << std::setw(5) << table.errors << std::right
+                  << "  " << (match ? "same" : "DIFFERENT") << std::endl;
+    }
+    return all_match ? 0 : 1;
+}
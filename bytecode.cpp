@@ -0,0 +1,98 @@
+#include "bytecode.h"
+#include <iomanip>
+
+namespace {
+
+const char* opName(OpCode op) {
+    switch (op) {
+        case OP_PUSH_INT: return "PUSH_INT";
+        case OP_PUSH_DOUBLE: return "PUSH_DOUBLE";
+        case OP_LOAD_GLOBAL: return "LOAD_GLOBAL";
+        case OP_STORE_GLOBAL: return "STORE_GLOBAL";
+        case OP_LOAD_LOCAL: return "LOAD_LOCAL";
+        case OP_STORE_LOCAL: return "STORE_LOCAL";
+        case OP_CLEAR_LOCAL: return "CLEAR_LOCAL";
+        case OP_POP: return "POP";
+        case OP_INT_TO_DOUBLE: return "INT_TO_DOUBLE";
+        case OP_INT_TO_DOUBLE_UNDER: return "INT_TO_DOUBLE_UNDER";
+        case OP_DOUBLE_TO_INT: return "DOUBLE_TO_INT";
+        case OP_NARROW: return "NARROW";
+        case OP_TEST_DOUBLE: return "TEST_DOUBLE";
+        case OP_ADD_I: return "ADD_I";
+        case OP_SUB_I: return "SUB_I";
+        case OP_MUL_I: return "MUL_I";
+        case OP_DIV_I: return "DIV_I";
+        case OP_MOD_I: return "MOD_I";
+        case OP_SHL: return "SHL";
+        case OP_SHR: return "SHR";
+        case OP_AND: return "AND";
+        case OP_OR: return "OR";
+        case OP_XOR: return "XOR";
+        case OP_EQ_I: return "EQ_I";
+        case OP_NE_I: return "NE_I";
+        case OP_LT_I: return "LT_I";
+        case OP_LE_I: return "LE_I";
+        case OP_GT_I: return "GT_I";
+        case OP_GE_I: return "GE_I";
+        case OP_ADD_D: return "ADD_D";
+        case OP_SUB_D: return "SUB_D";
+        case OP_MUL_D: return "MUL_D";
+        case OP_DIV_D: return "DIV_D";
+        case OP_EQ_D: return "EQ_D";
+        case OP_NE_D: return "NE_D";
+        case OP_LT_D: return "LT_D";
+        case OP_LE_D: return "LE_D";
+        case OP_GT_D: return "GT_D";
+        case OP_GE_D: return "GE_D";
+        case OP_NEG_I: return "NEG_I";
+        case OP_NEG_D: return "NEG_D";
+        case OP_JUMP: return "JUMP";
+        case OP_JUMP_IF_FALSE: return "JUMP_IF_FALSE";
+        case OP_CALL: return "CALL";
+        case OP_RETURN: return "RETURN";
+        case OP_HALT: return "HALT";
+    }
+    return "?";
+}
+
+bool hasArgument(OpCode op) {
+    switch (op) {
+        case OP_PUSH_INT: case OP_PUSH_DOUBLE:
+        case OP_LOAD_GLOBAL: case OP_STORE_GLOBAL:
+        case OP_LOAD_LOCAL: case OP_STORE_LOCAL: case OP_CLEAR_LOCAL:
+        case OP_NARROW: case OP_JUMP: case OP_JUMP_IF_FALSE: case OP_CALL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+void Bytecode::print(std::ostream& out) const {
+    out << "--- Bytecode ---" << std::endl;
+    for (const BytecodeGlobal& g : globals) {
+        out << "global " << atom_table.name(g.name) << " (" << SemanticAnalyzer::dataTypeToString(g.type) << ")" << std::endl;
+    }
+    size_t next_function = 0;
+    for (size_t ip = 0; ip < code.size(); ++ip) {
+        // Функции нумеруются в порядке описаний, а значит и адресов
+        while (next_function < functions.size() && functions[next_function].entry == ip) {
+            const BytecodeFunction& f = functions[next_function++];
+            out << atom_table.name(f.name) << ": params " << f.param_count << ", frame " << f.frame_size << std::endl;
+        }
+        const Instruction& in = code[ip];
+        out << std::setw(6) << ip << "  " << opName(in.op);
+        if (in.op == OP_PUSH_DOUBLE) {
+            out << ' ' << doubles[in.arg];
+        } else if (in.op == OP_NARROW) {
+            out << ' ' << SemanticAnalyzer::dataTypeToString(static_cast<DataType>(in.arg));
+        } else if (in.op == OP_CALL) {
+            out << ' ' << atom_table.name(functions[in.arg].name);
+        } else if (hasArgument(in.op)) {
+            out << ' ' << in.arg;
+        }
+        out << std::endl;
+    }
+    out << "----------------" << std::endl;
+}
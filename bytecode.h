@@ -0,0 +1,69 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "intern.h"
+#include "semantic.h"
+
+// Байт-код стековой машины (см. CodeEmitter, VirtualMachine). Операнды
+// выражений лежат на стеке значений; целые значения - 64-битные, результат
+// целой бинарной операции имеет тип int и обрезается до 32 бит, запись в
+// переменную приводит значение к её типу.
+enum OpCode : uint8_t {
+    OP_PUSH_INT,          // arg - значение
+    OP_PUSH_DOUBLE,       // arg - номер в Bytecode::doubles
+    OP_LOAD_GLOBAL,       // arg - номер глобальной переменной
+    OP_STORE_GLOBAL,
+    OP_LOAD_LOCAL,        // arg - номер ячейки кадра (параметры - первые)
+    OP_STORE_LOCAL,
+    OP_CLEAR_LOCAL,       // Обнулить ячейку (описание без инициализатора)
+    OP_POP,
+    OP_INT_TO_DOUBLE,
+    OP_INT_TO_DOUBLE_UNDER, // То же для значения под вершиной
+    OP_DOUBLE_TO_INT,
+    OP_NARROW,            // arg - DataType: обрезать целое до разрядности типа
+    OP_TEST_DOUBLE,       // Вещественное -> 0 или 1
+    OP_ADD_I, OP_SUB_I, OP_MUL_I, OP_DIV_I, OP_MOD_I,
+    OP_SHL, OP_SHR, OP_AND, OP_OR, OP_XOR,
+    OP_EQ_I, OP_NE_I, OP_LT_I, OP_LE_I, OP_GT_I, OP_GE_I,
+    OP_ADD_D, OP_SUB_D, OP_MUL_D, OP_DIV_D,
+    OP_EQ_D, OP_NE_D, OP_LT_D, OP_LE_D, OP_GT_D, OP_GE_D,
+    OP_NEG_I, OP_NEG_D,
+    OP_JUMP,              // arg - адрес
+    OP_JUMP_IF_FALSE,     // Снять целое; 0 - перейти на arg
+    OP_CALL,              // arg - номер в Bytecode::functions
+    OP_RETURN,
+    OP_HALT
+};
+
+struct Instruction {
+    OpCode op;
+    int32_t arg;
+};
+
+struct BytecodeFunction {
+    Atom name;
+    uint32_t entry;       // Адрес первой команды тела
+    uint32_t param_count; // Аргументы - верхние значения стека при вызове
+    uint32_t frame_size;  // Ячеек кадра вместе с параметрами
+};
+
+struct BytecodeGlobal {
+    Atom name;
+    DataType type;
+};
+
+// Программа целиком: выполнение начинается с адреса 0 (инициализаторы
+// глобальных переменных по порядку, затем вызов main, если она есть)
+struct Bytecode {
+    std::vector<Instruction> code;
+    std::vector<double> doubles;
+    std::vector<BytecodeFunction> functions;
+    std::vector<BytecodeGlobal> globals;
+
+    void print(std::ostream& out) const; // Листинг
+};
+
+#endif // BYTECODE_H
@@ -0,0 +1,215 @@
+#include "charscan.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define CHARSCAN_X86 1
+#include <immintrin.h>
+#endif
+
+// --- Скалярные версии (они же обрабатывают хвосты векторных) ---
+
+static inline bool isSpaceChar(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline bool isIdentChar(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+}
+
+static inline bool isDigitChar(unsigned char c) {
+    return c >= '0' && c <= '9';
+}
+
+static inline bool isHexDigitChar(unsigned char c) {
+    return isDigitChar(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f');
+}
+
+static const char* spacesScalar(const char* p, const char* end) {
+    while (p < end && isSpaceChar(*p)) p++;
+    return p;
+}
+
+static const char* identScalar(const char* p, const char* end) {
+    while (p < end && isIdentChar(*p)) p++;
+    return p;
+}
+
+static const char* digitsScalar(const char* p, const char* end) {
+    while (p < end && isDigitChar(*p)) p++;
+    return p;
+}
+
+static const char* hexDigitsScalar(const char* p, const char* end) {
+    while (p < end && isHexDigitChar(*p)) p++;
+    return p;
+}
+
+static const char* asciiScalar(const char* p, const char* end) {
+    while (p < end && static_cast<unsigned char>(*p) < 0x80) p++;
+    return p;
+}
+
+#ifdef CHARSCAN_X86
+
+// --- SSE2: 16 байт за итерацию ---
+// Сравнения знаковые: байты >= 0x80 отрицательны и не попадают ни в один класс.
+
+static inline __m128i inRange16(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+
+static inline __m128i identMask16(__m128i v) {
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i m = _mm_or_si128(inRange16(lower, 'a', 'z'), inRange16(v, '0', '9'));
+    return _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+}
+
+static inline __m128i hexMask16(__m128i v) {
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    return _mm_or_si128(inRange16(lower, 'a', 'f'), inRange16(v, '0', '9'));
+}
+
+static inline __m128i spaceMask16(__m128i v) {
+    return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), inRange16(v, '\t', '\r'));
+}
+
+#define CHARSCAN_RUN16(name, mask_fn, tail_fn)                                       \
+    static const char* name(const char* p, const char* end) {                       \
+        while (end - p >= 16) {                                                      \
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));        \
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(mask_fn(v)));    \
+            if (mask != 0xFFFFu) return p + __builtin_ctz(~mask);                    \
+            p += 16;                                                                 \
+        }                                                                            \
+        return tail_fn(p, end);                                                      \
+    }
+
+static inline __m128i digitMask16(__m128i v) { return inRange16(v, '0', '9'); }
+static inline __m128i asciiMask16(__m128i v) { return _mm_cmpgt_epi8(v, _mm_set1_epi8(-1)); }
+
+CHARSCAN_RUN16(spacesSse2, spaceMask16, spacesScalar)
+CHARSCAN_RUN16(identSse2, identMask16, identScalar)
+CHARSCAN_RUN16(digitsSse2, digitMask16, digitsScalar)
+CHARSCAN_RUN16(hexDigitsSse2, hexMask16, hexDigitsScalar)
+CHARSCAN_RUN16(asciiSse2, asciiMask16, asciiScalar)
+
+// --- AVX2: 32 байта за итерацию ---
+
+#define CHARSCAN_AVX2 __attribute__((target("avx2")))
+
+CHARSCAN_AVX2 static inline __m256i inRange32(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+}
+
+CHARSCAN_AVX2 static inline __m256i identMask32(__m256i v) {
+    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    __m256i m = _mm256_or_si256(inRange32(lower, 'a', 'z'), inRange32(v, '0', '9'));
+    return _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+}
+
+CHARSCAN_AVX2 static inline __m256i hexMask32(__m256i v) {
+    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    return _mm256_or_si256(inRange32(lower, 'a', 'f'), inRange32(v, '0', '9'));
+}
+
+CHARSCAN_AVX2 static inline __m256i digitMask32(__m256i v) { return inRange32(v, '0', '9'); }
+
+CHARSCAN_AVX2 static inline __m256i asciiMask32(__m256i v) {
+    return _mm256_cmpgt_epi8(v, _mm256_set1_epi8(-1));
+}
+
+CHARSCAN_AVX2 static inline __m256i spaceMask32(__m256i v) {
+    return _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), inRange32(v, '\t', '\r'));
+}
+
+#define CHARSCAN_RUN32(name, mask_fn, tail_fn)                                           \
+    CHARSCAN_AVX2 static const char* name(const char* p, const char* end) {             \
+        while (end - p >= 32) {                                                          \
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));         \
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(mask_fn(v)));     \
+            if (mask != 0xFFFFFFFFu) return p + __builtin_ctz(~mask);                    \
+            p += 32;                                                                     \
+        }                                                                                \
+        return tail_fn(p, end);                                                          \
+    }
+
+CHARSCAN_RUN32(spacesAvx2, spaceMask32, spacesSse2)
+CHARSCAN_RUN32(identAvx2, identMask32, identSse2)
+CHARSCAN_RUN32(digitsAvx2, digitMask32, digitsSse2)
+CHARSCAN_RUN32(hexDigitsAvx2, hexMask32, hexDigitsSse2)
+CHARSCAN_RUN32(asciiAvx2, asciiMask32, asciiSse2)
+
+#endif // CHARSCAN_X86
+
+// --- Выбор реализации ---
+
+struct CharScanKernels {
+    const char* name;
+    const char* (*spaces)(const char*, const char*);
+    const char* (*ident)(const char*, const char*);
+    const char* (*digits)(const char*, const char*);
+    const char* (*hex_digits)(const char*, const char*);
+    const char* (*ascii)(const char*, const char*);
+};
+
+static const CharScanKernels scalar_kernels = {
+    "scalar", spacesScalar, identScalar, digitsScalar, hexDigitsScalar, asciiScalar
+};
+
+#ifdef CHARSCAN_X86
+static const CharScanKernels sse2_kernels = {
+    "sse2", spacesSse2, identSse2, digitsSse2, hexDigitsSse2, asciiSse2
+};
+static const CharScanKernels avx2_kernels = {
+    "avx2", spacesAvx2, identAvx2, digitsAvx2, hexDigitsAvx2, asciiAvx2
+};
+#endif
+
+static CharScanKernels selectKernels() {
+    const char* forced = std::getenv("TRANSLATOR_SIMD");
+    if (forced != nullptr && std::strcmp(forced, "scalar") == 0) return scalar_kernels;
+#ifdef CHARSCAN_X86
+    __builtin_cpu_init();
+    bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (forced != nullptr && std::strcmp(forced, "sse2") == 0) return sse2_kernels;
+    if (has_avx2) return avx2_kernels;
+    return sse2_kernels; // SSE2 входит в базовый набор x86-64
+#endif
+    return scalar_kernels;
+}
+
+static const CharScanKernels kernels = selectKernels();
+
+const char* scanSpaces(const char* p, const char* end) {
+    return kernels.spaces(p, end);
+}
+
+const char* scanToNewline(const char* p, const char* end) {
+    // memchr в libc уже векторизован под текущий процессор
+    const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return nl != nullptr ? static_cast<const char*>(nl) : end;
+}
+
+const char* scanIdent(const char* p, const char* end) {
+    return kernels.ident(p, end);
+}
+
+const char* scanDigits(const char* p, const char* end) {
+    return kernels.digits(p, end);
+}
+
+const char* scanHexDigits(const char* p, const char* end) {
+    return kernels.hex_digits(p, end);
+}
+
+const char* scanAscii(const char* p, const char* end) {
+    return kernels.ascii(p, end);
+}
+
+const char* charScanImplName() {
+    return kernels.name;
+}
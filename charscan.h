@@ -0,0 +1,28 @@
+#ifndef CHARSCAN_H
+#define CHARSCAN_H
+
+#include <cstddef>
+
+// Ядра классификации символов для сканера. Каждое ядро возвращает указатель
+// на первый символ в [p, end), не принадлежащий своему классу.
+// Реализация (скалярная, SSE2 или AVX2) выбирается один раз при запуске по
+// возможностям процессора; переменная окружения TRANSLATOR_SIMD=scalar|sse2|avx2
+// позволяет принудительно выбрать вариант для сравнения производительности.
+
+// Пробельные символы (как isspace в локали "C")
+const char* scanSpaces(const char* p, const char* end);
+// Тело комментария "//": первый '\n' или end
+const char* scanToNewline(const char* p, const char* end);
+// Символы идентификатора: [A-Za-z0-9_]
+const char* scanIdent(const char* p, const char* end);
+// Десятичные цифры
+const char* scanDigits(const char* p, const char* end);
+// Шестнадцатеричные цифры
+const char* scanHexDigits(const char* p, const char* end);
+// Символы ASCII (байты < 0x80)
+const char* scanAscii(const char* p, const char* end);
+
+// Имя выбранной реализации ("scalar", "sse2", "avx2")
+const char* charScanImplName();
+
+#endif // CHARSCAN_H
@@ -0,0 +1,57 @@
+// Проверка арены (make check): индексы остаются в своих блоках и после
+// clear(), когда блоки, выделенные под большие срезы, используются снова.
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "arena.h"
+
+typedef BumpArena<uint32_t, 4> SmallArena; // Блоки по 16 элементов
+
+static int failures = 0;
+
+static void expect(bool ok, const char* what) {
+    if (!ok) {
+        std::cerr << "FAIL: " << what << std::endl;
+        failures++;
+    }
+}
+
+// Заполнить арену одиночными элементами (значение - номер) и прочитать их по индексам
+static void fillAndRead(SmallArena& arena, uint32_t count, const char* what) {
+    std::vector<uint32_t> indices;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t index = arena.allocate();
+        *arena.at(index) = i;
+        indices.push_back(index);
+    }
+    bool ok = true;
+    for (uint32_t i = 0; i < count; ++i) ok = ok && *arena.at(indices[i]) == i;
+    expect(ok, what);
+}
+
+int main() {
+    SmallArena arena;
+
+    // Срез больше блока лежит подряд
+    uint32_t big = arena.allocate(100);
+    for (uint32_t i = 0; i < 100; ++i) arena.at(big)[i] = i;
+    bool ok = true;
+    for (uint32_t i = 0; i < 100; ++i) ok = ok && arena.at(big)[i] == i;
+    expect(ok, "большой срез");
+    fillAndRead(arena, 50, "одиночные элементы после большого среза");
+
+    // После clear() первым снова идёт блок большого среза
+    arena.clear();
+    fillAndRead(arena, 200, "одиночные элементы после clear()");
+
+    arena.clear();
+    uint32_t slice = arena.allocate(10);
+    for (uint32_t i = 0; i < 10; ++i) arena.at(slice)[i] = 1000 + i;
+    fillAndRead(arena, 100, "срезы и одиночные элементы после clear()");
+    ok = true;
+    for (uint32_t i = 0; i < 10; ++i) ok = ok && arena.at(slice)[i] == 1000 + i;
+    expect(ok, "срез не перезаписан");
+
+    if (failures == 0) std::cout << "arena: OK" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+// Проверка таблиц типизации (make check): каждый элемент binary_rules и
+// conversions сравнивается с прежними проверками semCheckBinaryExpr,
+// semCheckAssignment и Parser::checkArgument, записанными здесь заново
+// условиями, без таблиц.
+#include <iostream>
+#include <string>
+#include "type_rules.h"
+
+static int failures = 0;
+
+static const char* typeName(size_t type) {
+    static const char* const names[] = {"undefined", "int", "short", "long", "double", "char", "void"};
+    return names[type];
+}
+
+static bool oldIntFamily(DataType type) {
+    return type == TYPE_INT || type == TYPE_SHORT || type == TYPE_LONG || type == TYPE_CHAR;
+}
+
+// Прежний semCheckBinaryExpr: тип результата, error - сообщение об ошибке
+static DataType oldBinary(TokenType op, DataType left, DataType right, bool& error) {
+    error = false;
+    if (left == TYPE_UNDEFINED || right == TYPE_UNDEFINED) return TYPE_UNDEFINED;
+    bool left_int = oldIntFamily(left);
+    bool right_int = oldIntFamily(right);
+    switch (op) {
+        case T_PLUS: case T_MINUS: case T_MUL: case T_DIV:
+            if (left == TYPE_DOUBLE || right == TYPE_DOUBLE) return TYPE_DOUBLE;
+            if (left_int && right_int) return TYPE_INT;
+            break;
+        case T_MOD:
+            if (left_int && right_int) return TYPE_INT;
+            break;
+        case T_BIT_OR: case T_BIT_XOR: case T_BIT_AND: case T_LSHIFT: case T_RSHIFT:
+            if (left_int && right_int) return TYPE_INT;
+            break;
+        case T_EQ: case T_NE: case T_LT: case T_LE: case T_GT: case T_GE:
+            if ((left_int || left == TYPE_DOUBLE) && (right_int || right == TYPE_DOUBLE)) return TYPE_INT;
+            break;
+        default:
+            break;
+    }
+    error = true;
+    return TYPE_UNDEFINED;
+}
+
+// Прежний semCheckAssignment (часть, зависящая только от типов)
+static Conversion oldAssign(DataType left, DataType right) {
+    if (left == right || right == TYPE_UNDEFINED) return CONV_OK;
+    if (left == TYPE_DOUBLE && oldIntFamily(right)) return CONV_OK;
+    if (oldIntFamily(left) && right == TYPE_DOUBLE) return CONV_NARROWING;
+    return CONV_INCOMPATIBLE;
+}
+
+// Прежний Parser::checkArgument: тип аргумента должен совпадать с типом параметра
+static Conversion oldArgument(DataType param, DataType arg) {
+    return arg != param && arg != TYPE_UNDEFINED ? CONV_INCOMPATIBLE : CONV_OK;
+}
+
+int main() {
+    size_t checked = 0;
+    for (size_t op = 0; op < TYPE_RULE_OPERATORS; ++op) {
+        for (size_t l = 0; l < TYPE_RULE_TYPES; ++l) {
+            for (size_t r = 0; r < TYPE_RULE_TYPES; ++r) {
+                bool error;
+                DataType result = oldBinary(static_cast<TokenType>(op), static_cast<DataType>(l), static_cast<DataType>(r), error);
+                const BinaryRule& rule = binary_rules[op][l][r];
+                // При ошибке тип результата не используется
+                if (rule.error != error || (!error && rule.result != result)) {
+                    std::cerr << "FAIL: binary_rules[" << op << "][" << typeName(l) << "][" << typeName(r) << "]" << std::endl;
+                    failures++;
+                }
+                checked++;
+            }
+        }
+    }
+
+    for (size_t to = 0; to < TYPE_RULE_TYPES; ++to) {
+        for (size_t from = 0; from < TYPE_RULE_TYPES; ++from) {
+            DataType to_type = static_cast<DataType>(to);
+            DataType from_type = static_cast<DataType>(from);
+            if (conversions[SITE_ASSIGN][to][from] != oldAssign(to_type, from_type)) {
+                std::cerr << "FAIL: присваивание " << typeName(from) << " -> " << typeName(to) << std::endl;
+                failures++;
+            }
+            if (conversions[SITE_ARGUMENT][to][from] != oldArgument(to_type, from_type)) {
+                std::cerr << "FAIL: аргумент " << typeName(from) << " -> " << typeName(to) << std::endl;
+                failures++;
+            }
+            checked += 2;
+        }
+    }
+
+    if (failures == 0) std::cout << "type rules: OK (" << checked << ")" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+#include "code_emitter.h"
+#include <algorithm>
+
+namespace {
+
+bool isIntegerType(DataType type) {
+    return type == TYPE_INT || type == TYPE_SHORT || type == TYPE_LONG || type == TYPE_CHAR;
+}
+
+// Разрядность целого типа
+int integerBits(DataType type) {
+    switch (type) {
+        case TYPE_CHAR: return 8;
+        case TYPE_SHORT: return 16;
+        case TYPE_INT: return 32;
+        default: return 64;
+    }
+}
+
+// Команда бинарной операции над целыми или вещественными; OP_HALT - нет такой
+OpCode binaryOp(TokenType op, bool real) {
+    switch (op) {
+        case T_PLUS: return real ? OP_ADD_D : OP_ADD_I;
+        case T_MINUS: return real ? OP_SUB_D : OP_SUB_I;
+        case T_MUL: return real ? OP_MUL_D : OP_MUL_I;
+        case T_DIV: return real ? OP_DIV_D : OP_DIV_I;
+        case T_EQ: return real ? OP_EQ_D : OP_EQ_I;
+        case T_NE: return real ? OP_NE_D : OP_NE_I;
+        case T_LT: return real ? OP_LT_D : OP_LT_I;
+        case T_LE: return real ? OP_LE_D : OP_LE_I;
+        case T_GT: return real ? OP_GT_D : OP_GT_I;
+        case T_GE: return real ? OP_GE_D : OP_GE_I;
+        case T_MOD: return real ? OP_HALT : OP_MOD_I;
+        case T_LSHIFT: return real ? OP_HALT : OP_SHL;
+        case T_RSHIFT: return real ? OP_HALT : OP_SHR;
+        case T_BIT_AND: return real ? OP_HALT : OP_AND;
+        case T_BIT_OR: return real ? OP_HALT : OP_OR;
+        case T_BIT_XOR: return real ? OP_HALT : OP_XOR;
+        default: return OP_HALT;
+    }
+}
+
+} // namespace
+
+const Bytecode& CodeEmitter::getBytecode() const {
+    return bytecode;
+}
+
+void CodeEmitter::emit(OpCode op, int32_t arg) {
+    bytecode.code.push_back({op, arg});
+}
+
+uint32_t CodeEmitter::localSlot() {
+    uint32_t slot = next_slot++;
+    if (!functions.empty()) {
+        BytecodeFunction& f = bytecode.functions[functions.back().index];
+        f.frame_size = std::max(f.frame_size, next_slot);
+    }
+    return slot;
+}
+
+// --- Переменные ---
+
+void CodeEmitter::declareVariable(Symbol* var, bool added) {
+    if (!added) {
+        var->var_info.slot = NO_SLOT;
+    } else if (SemanticAnalyzer::isGlobal(var)) {
+        var->var_info.slot = static_cast<uint32_t>(bytecode.globals.size());
+        bytecode.globals.push_back({var->name, var->type});
+    } else {
+        var->var_info.slot = localSlot();
+    }
+}
+
+// Параметры занимают первые ячейки кадра в порядке описания, даже повторно
+// объявленные: ячейка соответствует месту аргумента
+void CodeEmitter::declareParameter(Symbol* param) {
+    param->var_info.slot = localSlot();
+    bytecode.functions[functions.back().index].param_count++;
+}
+
+// Глобальные переменные обнулены с начала программы, а локальная может
+// занять ячейку переменной закрытого блока или прошлой итерации цикла
+void CodeEmitter::clearVariable(const Symbol* var) {
+    if (var->var_info.slot == NO_SLOT || SemanticAnalyzer::isGlobal(var)) return;
+    emit(OP_CLEAR_LOCAL, static_cast<int32_t>(var->var_info.slot));
+}
+
+void CodeEmitter::load(const Symbol* var) {
+    emit(SemanticAnalyzer::isGlobal(var) ? OP_LOAD_GLOBAL : OP_LOAD_LOCAL, static_cast<int32_t>(var->var_info.slot));
+}
+
+void CodeEmitter::store(const Symbol* var, DataType value_type) {
+    if (var->var_info.slot == NO_SLOT) {
+        emit(OP_POP);
+        return;
+    }
+    convert(value_type, var->type);
+    emit(SemanticAnalyzer::isGlobal(var) ? OP_STORE_GLOBAL : OP_STORE_LOCAL, static_cast<int32_t>(var->var_info.slot));
+}
+
+// Целые константы сканер уже ограничил 32 битами
+void CodeEmitter::pushInt(int64_t value) {
+    emit(OP_PUSH_INT, static_cast<int32_t>(value));
+}
+
+void CodeEmitter::pushDouble(double value) {
+    emit(OP_PUSH_DOUBLE, static_cast<int32_t>(bytecode.doubles.size()));
+    bytecode.doubles.push_back(value);
+}
+
+void CodeEmitter::convert(DataType from, DataType to) {
+    if (from == TYPE_UNDEFINED || from == to) return;
+    if (to == TYPE_DOUBLE) {
+        if (isIntegerType(from)) emit(OP_INT_TO_DOUBLE);
+        return;
+    }
+    if (!isIntegerType(to)) return;
+    if (from == TYPE_DOUBLE) {
+        emit(OP_DOUBLE_TO_INT);
+        if (to != TYPE_LONG) emit(OP_NARROW, to);
+    } else if (isIntegerType(from) && integerBits(from) > integerBits(to)) {
+        emit(OP_NARROW, to);
+    }
+}
+
+// --- Выражения ---
+
+void CodeEmitter::binary(TokenType op, DataType left_type, DataType right_type) {
+    if (left_type == TYPE_UNDEFINED || right_type == TYPE_UNDEFINED) return;
+    bool real = left_type == TYPE_DOUBLE || right_type == TYPE_DOUBLE;
+    OpCode code = binaryOp(op, real);
+    if (code == OP_HALT) return; // Ошибка типов уже сообщена
+    if (real && left_type != TYPE_DOUBLE) emit(OP_INT_TO_DOUBLE_UNDER);
+    if (real && right_type != TYPE_DOUBLE) emit(OP_INT_TO_DOUBLE);
+    emit(code);
+}
+
+// Унарный минус сохраняет тип операнда
+void CodeEmitter::unary(TokenType op, DataType type) {
+    if (op != T_MINUS) return;
+    if (type == TYPE_DOUBLE) {
+        emit(OP_NEG_D);
+    } else if (isIntegerType(type)) {
+        emit(OP_NEG_I);
+        if (type != TYPE_LONG) emit(OP_NARROW, type);
+    }
+}
+
+// --- Операторы ---
+
+void CodeEmitter::openBlock() {
+    block_slots.push_back(next_slot);
+}
+
+void CodeEmitter::closeBlock() {
+    next_slot = block_slots.back();
+    block_slots.pop_back();
+}
+
+uint32_t CodeEmitter::here() const {
+    return static_cast<uint32_t>(bytecode.code.size());
+}
+
+uint32_t CodeEmitter::jumpIfFalse(DataType cond_type) {
+    if (cond_type == TYPE_DOUBLE) emit(OP_TEST_DOUBLE);
+    uint32_t jump = here();
+    emit(OP_JUMP_IF_FALSE);
+    return jump;
+}
+
+void CodeEmitter::loopEnd(uint32_t loop_start, uint32_t exit_jump) {
+    emit(OP_JUMP, static_cast<int32_t>(loop_start));
+    bytecode.code[exit_jump].arg = static_cast<int32_t>(here());
+}
+
+// Тело функции лежит среди инициализаторов глобальных переменных, поэтому
+// перед ним - переход через него
+void CodeEmitter::beginFunction(Symbol* func) {
+    uint32_t index = static_cast<uint32_t>(bytecode.functions.size());
+    func->func_info.code = index;
+    functions.push_back({index, here()});
+    emit(OP_JUMP);
+    bytecode.functions.push_back({func->name, here(), 0, 0});
+    next_slot = 0;
+    block_slots.clear();
+}
+
+void CodeEmitter::endFunction() {
+    emit(OP_RETURN);
+    bytecode.code[functions.back().skip_jump].arg = static_cast<int32_t>(here());
+    functions.pop_back();
+}
+
+void CodeEmitter::call(const Symbol* func) {
+    emit(OP_CALL, static_cast<int32_t>(func->func_info.code));
+}
+
+void CodeEmitter::finishProgram(const Symbol* main_sym) {
+    if (main_sym != nullptr && main_sym->category == CAT_FUNCTION && main_sym->func_info.param_count == 0) {
+        call(main_sym);
+    }
+    emit(OP_HALT);
+}
@@ -0,0 +1,70 @@
+#ifndef CODE_EMITTER_H
+#define CODE_EMITTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bytecode.h"
+#include "scanner.h"
+#include "semantic.h"
+
+const uint32_t NO_SLOT = UINT32_MAX; // Переменная не попала в таблицу: значение выбрасывается
+
+// Генерация байт-кода по ходу разбора (Parser::setEmitter). Парсер вызывает
+// методы в тех же местах, где проверяет типы, поэтому команды выходят в
+// порядке разбора: операнды раньше операции, переходы вперёд дописываются,
+// когда становится известен адрес. Дерево не нужно, весь вход - один
+// проход; типы операндов приходят из возвращаемых значений функций
+// разбора и выбирают целую или вещественную команду и преобразования.
+//
+// После синтаксической или семантической ошибки байт-код неполон и
+// выполняться не должен.
+class CodeEmitter {
+public:
+    const Bytecode& getBytecode() const;
+
+    // --- Переменные ---
+    // Глобальная переменная получает номер в Bytecode::globals, локальная -
+    // ячейку кадра (ячейки закрытых блоков используются снова)
+    void declareVariable(Symbol* var, bool added);
+    void declareParameter(Symbol* param);
+    void clearVariable(const Symbol* var);   // Описание без инициализатора
+    void load(const Symbol* var);
+    void store(const Symbol* var, DataType value_type);
+    void pushInt(int64_t value);
+    void pushDouble(double value);
+    // Привести значение на вершине к типу to (аргумент вызова, запись)
+    void convert(DataType from, DataType to);
+
+    // --- Выражения ---
+    void binary(TokenType op, DataType left_type, DataType right_type);
+    void unary(TokenType op, DataType type);
+
+    // --- Операторы ---
+    void openBlock();
+    void closeBlock();
+    uint32_t here() const;                      // Адрес следующей команды
+    uint32_t jumpIfFalse(DataType cond_type);   // Переход вперёд; вернуть его адрес
+    void loopEnd(uint32_t loop_start, uint32_t exit_jump);
+    void beginFunction(Symbol* func);
+    void endFunction();
+    void call(const Symbol* func);
+    // Конец программы: вызов main (nullptr или не функция - без вызова)
+    void finishProgram(const Symbol* main_sym);
+
+private:
+    struct OpenFunction {
+        uint32_t index;      // Номер в Bytecode::functions
+        uint32_t skip_jump;  // Переход через тело
+    };
+
+    Bytecode bytecode;
+    uint32_t next_slot = 0;              // Первая свободная ячейка кадра
+    std::vector<uint32_t> block_slots;   // next_slot при входе в блоки
+    std::vector<OpenFunction> functions;
+
+    void emit(OpCode op, int32_t arg = 0);
+    uint32_t localSlot();
+};
+
+#endif // CODE_EMITTER_H
@@ -0,0 +1,91 @@
+#include "diagnostics.h"
+#include <iostream>
+
+void DiagnosticSink::error(SourceLoc loc, std::string before, std::string after) {
+    error_count++;
+    if (errors.size() < MAX_STORED_ERRORS) {
+        errors.push_back({loc, std::move(before), std::move(after)});
+    }
+}
+
+void DiagnosticSink::error(std::string message) {
+    error(NO_SOURCE_LOC, std::move(message), std::string());
+}
+
+void DiagnosticSink::clear() {
+    errors.clear();
+    deferred_warnings.clear();
+    error_count = 0;
+}
+
+void DiagnosticSink::warning(const SourceMap& map, SourceLoc loc, std::string before, std::string after,
+                             Atom global) {
+    if (!warnings) return;
+    if (defer) {
+        deferred_warnings.push_back({{loc, std::move(before), std::move(after)}, global});
+    } else {
+        std::cout << before << map.describe(loc) << after << std::endl;
+    }
+}
+
+void DiagnosticSink::setWarnings(bool enabled) {
+    warnings = enabled;
+}
+
+bool DiagnosticSink::warningsEnabled() const {
+    return warnings;
+}
+
+void DiagnosticSink::deferWarnings(bool deferred) {
+    defer = deferred;
+}
+
+void DiagnosticSink::append(const DiagnosticSink& other) {
+    for (const Diagnostic& d : other.errors) {
+        if (errors.size() < MAX_STORED_ERRORS) errors.push_back(d);
+    }
+    error_count += other.error_count;
+    deferred_warnings.insert(deferred_warnings.end(), other.deferred_warnings.begin(),
+                             other.deferred_warnings.end());
+}
+
+size_t DiagnosticSink::errorCount() const {
+    return error_count;
+}
+
+bool DiagnosticSink::hasErrors() const {
+    return error_count != 0;
+}
+
+const std::vector<Diagnostic>& DiagnosticSink::getErrors() const {
+    return errors;
+}
+
+void DiagnosticSink::printError(std::ostream& out, const Diagnostic& d, const SourceMap& map) {
+    out << "Syntax error: " << d.before;
+    if (d.loc != NO_SOURCE_LOC) out << map.describe(d.loc);
+    out << d.after << '\n';
+}
+
+void DiagnosticSink::printWarnings(std::ostream& out, const SourceMap& map,
+                                   const std::unordered_set<Atom>& initialized) const {
+    for (const Warning& w : deferred_warnings) {
+        if (w.global != ATOM_NONE && initialized.count(w.global) != 0) continue;
+        out << w.text.before << map.describe(w.text.loc) << w.text.after << '\n';
+    }
+    out.flush();
+}
+
+void DiagnosticSink::print(std::ostream& out, const SourceMap& map) const {
+    for (const Diagnostic& d : errors) {
+        printError(out, d, map);
+    }
+    if (error_count > errors.size()) {
+        out << "... и ещё " << (error_count - errors.size()) << " ошибок" << '\n';
+    }
+    if (error_count > 1) {
+        out << "Найдено ошибок: " << error_count << std::endl;
+    } else {
+        out.flush();
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "location.h"
+#include "intern.h"
+
+const size_t MAX_STORED_ERRORS = 1000; // Сколько сообщений хранить (счёт ведётся всем)
+const SourceLoc NO_SOURCE_LOC = UINT32_MAX; // Сообщение без позиции
+
+// Сообщение об ошибке. Позиция хранится отдельно от текста и превращается
+// в строку:столбец только при выводе, поэтому сообщение можно сдвинуть
+// вместе с его описанием после правки текста (см. IncrementalParser).
+struct Diagnostic {
+    SourceLoc loc;
+    std::string before; // Текст до позиции
+    std::string after;  // Текст после позиции
+};
+
+// Отложенное предупреждение (см. DiagnosticSink::deferWarnings)
+struct Warning {
+    Diagnostic text;
+    Atom global;        // Неинициализированная глобальная переменная (иначе ATOM_NONE)
+};
+
+// Приёмник диагностики. Парсер и семантический анализатор не прерывают
+// разбор на первой ошибке, а сообщают о ней сюда и продолжают, поэтому
+// один запуск находит все ошибки файла. Выводятся сообщения в порядке
+// поступления, то есть в порядке текста программы.
+class DiagnosticSink {
+public:
+    void error(SourceLoc loc, std::string before, std::string after);
+    void error(std::string message); // Без позиции
+    void clear();
+
+    // Предупреждения печатаются сразу (std::cout); их можно отключить
+    // или отложить. global - глобальная переменная, о неинициализированности
+    // которой предупреждение (отложенное снимается, если ей присвоили
+    // значение в другой функции, см. printWarnings).
+    void warning(const SourceMap& map, SourceLoc loc, std::string before, std::string after,
+                 Atom global = ATOM_NONE);
+    void setWarnings(bool enabled);
+    bool warningsEnabled() const;
+    void deferWarnings(bool deferred);
+
+    // Дописать сообщения другого приёмника в конец этого
+    void append(const DiagnosticSink& other);
+
+    size_t errorCount() const;
+    bool hasErrors() const;
+    const std::vector<Diagnostic>& getErrors() const;
+
+    // Каждая ошибка - "Syntax error: <текст>", при нескольких - итоговая строка
+    void print(std::ostream& out, const SourceMap& map) const;
+    static void printError(std::ostream& out, const Diagnostic& d, const SourceMap& map);
+    // Отложенные предупреждения, кроме предупреждений о глобальных
+    // переменных из initialized
+    void printWarnings(std::ostream& out, const SourceMap& map,
+                       const std::unordered_set<Atom>& initialized) const;
+
+private:
+    std::vector<Diagnostic> errors;
+    std::vector<Warning> deferred_warnings;
+    size_t error_count = 0;
+    bool warnings = true;
+    bool defer = false;
+};
+
+#endif // DIAGNOSTICS_H
@@ -0,0 +1,323 @@
+#ifndef GRAMMAR_H
+#define GRAMMAR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include "scanner.h"
+
+// Грамматика языка для табличного разбора (parser_table.cpp). Множества
+// FIRST и FOLLOW и таблица предсказаний LL(1) вычисляются компилятором;
+// конфликт в таблице - ошибка сборки. Новое правило - новая строка в
+// grammar_rules, без правки разборщика.
+//
+// Грамматика та же, что у рекурсивного спуска (parser.h), но без левой
+// рекурсии и с вынесенными общими началами: списки стали правой рекурсией
+// (*_REST), уровни приоритета операций - отдельными нетерминалами, а
+// оператор, начинающийся с имени, разбирается как имя и хвост (STMT_TAIL).
+// Семантические действия (@...) стоят в правилах как символы, выполняемые в
+// своём месте разбора; на выбор правила они не влияют.
+
+// Нетерминалы; с буквенными именами - те же, что функции парсера
+enum Nonterminal : uint8_t {
+    NT_S,             // <программа>
+    NT_T,             // <список_описаний>
+    NT_W,             // <описание>
+    NT_D,             // <описание_данных>
+    NT_TP,            // <тип>
+    NT_Z,             // <список_переменных>
+    NT_Z_ITEM,        // переменная с необязательным инициализатором
+    NT_Z_INIT,
+    NT_Z_REST,
+    NT_NAME,          // идентификатор или main
+    NT_F,             // <описание_функции>
+    NT_G,             // <параметры>
+    NT_ZF,            // <список_параметров>
+    NT_ZF_REST,
+    NT_PS,            // <один_параметр>
+    NT_K,             // <список_операторов>
+    NT_O,             // <оператор>
+    NT_STMT_TAIL,     // присваивание или вызов после имени
+    NT_Q,             // <составной_оператор>
+    NT_U,             // <оператор_цикла>
+    NT_L,             // <входные_параметры>
+    NT_M,             // <список_входных_параметров>
+    NT_M_REST,
+    NT_V,             // <выражение>
+    NT_OR, NT_OR_REST,            // |
+    NT_XOR, NT_XOR_REST,          // ^
+    NT_AND, NT_AND_REST,          // &
+    NT_EQUALITY, NT_EQUALITY_REST, // == !=
+    NT_RELATION, NT_RELATION_REST, // < <= > >=
+    NT_SHIFT, NT_SHIFT_REST,      // << >>
+    NT_ADD, NT_ADD_REST,          // + -
+    NT_MUL, NT_MUL_REST,          // * / %
+    NT_UNARY,         // необязательный знак перед операндом
+    NT_E,             // <эл.выр.>
+    NT_C,             // <константа>
+    NT_COUNT
+};
+
+// Семантические действия. Действие в начале правила видит лексему, по
+// которой правило выбрано (она ещё текущая); действие после терминала -
+// этот терминал как последнюю сопоставленную лексему.
+enum GrammarAction : uint8_t {
+    ACT_PROGRAM_BEGIN, ACT_PROGRAM_END,
+    ACT_DATA_BEGIN, ACT_DATA_END, ACT_TYPE,
+    ACT_VAR, ACT_VAR_INIT, ACT_VAR_END,
+    ACT_FUNC_NAME, ACT_PARAM, ACT_FUNC_DECLARE, ACT_BODY_BEGIN, ACT_BODY_END, ACT_FUNC_END,
+    ACT_EMPTY,
+    ACT_ASSIGN_BEGIN, ACT_ASSIGN_END,
+    ACT_CALL_BEGIN, ACT_NO_ARGS, ACT_ARG, ACT_ARGS_END, ACT_CALL_END,
+    ACT_BLOCK_BEGIN, ACT_BLOCK_END,
+    ACT_WHILE_BEGIN, ACT_WHILE_COND, ACT_WHILE_END,
+    ACT_OP, ACT_BINARY, ACT_UNARY, ACT_NAME, ACT_CONST,
+    ACT_COUNT
+};
+
+// Символ правой части: терминал (тип лексемы), нетерминал или действие
+typedef uint8_t GrammarSymbol;
+
+const size_t GRAMMAR_TERMINALS = T_ERROR + 1;
+const size_t GRAMMAR_NONTERMINAL_BASE = GRAMMAR_TERMINALS;
+const size_t GRAMMAR_ACTION_BASE = GRAMMAR_NONTERMINAL_BASE + NT_COUNT;
+static_assert(GRAMMAR_ACTION_BASE + ACT_COUNT <= 256, "Символы грамматики не помещаются в байт");
+static_assert(GRAMMAR_TERMINALS <= 64, "Множества терминалов хранятся в 64-битных масках");
+
+constexpr GrammarSymbol nt(Nonterminal n) {
+    return static_cast<GrammarSymbol>(GRAMMAR_NONTERMINAL_BASE + n);
+}
+
+constexpr GrammarSymbol act(GrammarAction a) {
+    return static_cast<GrammarSymbol>(GRAMMAR_ACTION_BASE + a);
+}
+
+constexpr bool isTerminal(GrammarSymbol s) {
+    return s < GRAMMAR_NONTERMINAL_BASE;
+}
+
+constexpr bool isNonterminal(GrammarSymbol s) {
+    return s >= GRAMMAR_NONTERMINAL_BASE && s < GRAMMAR_ACTION_BASE;
+}
+
+const size_t MAX_RULE_LENGTH = 14;
+
+struct GrammarRule {
+    Nonterminal lhs;
+    uint8_t length;
+    GrammarSymbol rhs[MAX_RULE_LENGTH];
+};
+
+constexpr GrammarRule rule(Nonterminal lhs, std::initializer_list<GrammarSymbol> rhs) {
+    GrammarRule r{lhs, 0, {}};
+    for (GrammarSymbol s : rhs) r.rhs[r.length++] = s;
+    return r;
+}
+
+// X_REST -> op @OP X @BINARY X_REST: левоассоциативная операция op над операндами X
+constexpr GrammarRule binaryRule(Nonterminal rest, TokenType op, Nonterminal operand) {
+    return rule(rest, {static_cast<GrammarSymbol>(op), act(ACT_OP), nt(operand), act(ACT_BINARY), nt(rest)});
+}
+
+constexpr GrammarRule grammar_rules[] = {
+    // Общая структура программы
+    rule(NT_S, {act(ACT_PROGRAM_BEGIN), nt(NT_T), act(ACT_PROGRAM_END), T_EOF}),
+    rule(NT_T, {nt(NT_W), nt(NT_T)}),
+    rule(NT_T, {}),
+    rule(NT_W, {nt(NT_D)}),
+    rule(NT_W, {nt(NT_F)}),
+
+    // Описания
+    rule(NT_D, {act(ACT_DATA_BEGIN), nt(NT_TP), nt(NT_Z), T_SEMICOLON, act(ACT_DATA_END)}),
+    rule(NT_TP, {T_SHORT, act(ACT_TYPE)}),
+    rule(NT_TP, {T_LONG, act(ACT_TYPE)}),
+    rule(NT_TP, {T_INT, act(ACT_TYPE)}),
+    rule(NT_TP, {T_DOUBLE, act(ACT_TYPE)}),
+    rule(NT_TP, {T_CHAR, act(ACT_TYPE)}),
+    rule(NT_Z, {nt(NT_Z_ITEM), nt(NT_Z_REST)}),
+    rule(NT_Z_ITEM, {act(ACT_VAR), nt(NT_NAME), nt(NT_Z_INIT), act(ACT_VAR_END)}),
+    rule(NT_Z_INIT, {T_ASSIGN, nt(NT_V), act(ACT_VAR_INIT)}),
+    rule(NT_Z_INIT, {}),
+    rule(NT_Z_REST, {T_COMMA, nt(NT_Z_ITEM), nt(NT_Z_REST)}),
+    rule(NT_Z_REST, {}),
+    rule(NT_NAME, {T_IDENT}),
+    rule(NT_NAME, {T_MAIN}),
+    rule(NT_F, {T_VOID, nt(NT_NAME), act(ACT_FUNC_NAME), T_LPAREN, nt(NT_G), T_RPAREN, act(ACT_FUNC_DECLARE),
+                T_LBRACE, act(ACT_BODY_BEGIN), nt(NT_K), act(ACT_BODY_END), T_RBRACE, act(ACT_FUNC_END)}),
+
+    // Параметры функции
+    rule(NT_G, {nt(NT_ZF)}),
+    rule(NT_G, {}),
+    rule(NT_ZF, {nt(NT_PS), nt(NT_ZF_REST)}),
+    rule(NT_ZF_REST, {T_COMMA, nt(NT_PS), nt(NT_ZF_REST)}),
+    rule(NT_ZF_REST, {}),
+    rule(NT_PS, {nt(NT_TP), T_IDENT, act(ACT_PARAM)}),
+
+    // Операторы
+    rule(NT_K, {nt(NT_O), nt(NT_K)}),
+    rule(NT_K, {}),
+    rule(NT_O, {nt(NT_NAME), nt(NT_STMT_TAIL)}),
+    rule(NT_O, {nt(NT_D)}),
+    rule(NT_O, {nt(NT_Q)}),
+    rule(NT_O, {nt(NT_U)}),
+    rule(NT_O, {T_SEMICOLON, act(ACT_EMPTY)}),
+    rule(NT_STMT_TAIL, {act(ACT_ASSIGN_BEGIN), T_ASSIGN, nt(NT_V), act(ACT_ASSIGN_END), T_SEMICOLON}),
+    rule(NT_STMT_TAIL, {act(ACT_CALL_BEGIN), T_LPAREN, nt(NT_L), T_RPAREN, act(ACT_CALL_END), T_SEMICOLON}),
+    rule(NT_Q, {T_LBRACE, act(ACT_BLOCK_BEGIN), nt(NT_K), act(ACT_BLOCK_END), T_RBRACE}),
+    rule(NT_U, {T_WHILE, act(ACT_WHILE_BEGIN), T_LPAREN, nt(NT_V), act(ACT_WHILE_COND), T_RPAREN, nt(NT_O),
+                act(ACT_WHILE_END)}),
+
+    // Параметры вызова функции
+    rule(NT_L, {nt(NT_M)}),
+    rule(NT_L, {act(ACT_NO_ARGS)}),
+    rule(NT_M, {nt(NT_V), act(ACT_ARG), nt(NT_M_REST), act(ACT_ARGS_END)}),
+    rule(NT_M_REST, {T_COMMA, nt(NT_V), act(ACT_ARG), nt(NT_M_REST)}),
+    rule(NT_M_REST, {}),
+
+    // Выражения: уровни от слабой операции к сильной, все левоассоциативные
+    rule(NT_V, {nt(NT_OR)}),
+    rule(NT_OR, {nt(NT_XOR), nt(NT_OR_REST)}),
+    binaryRule(NT_OR_REST, T_BIT_OR, NT_XOR),
+    rule(NT_OR_REST, {}),
+    rule(NT_XOR, {nt(NT_AND), nt(NT_XOR_REST)}),
+    binaryRule(NT_XOR_REST, T_BIT_XOR, NT_AND),
+    rule(NT_XOR_REST, {}),
+    rule(NT_AND, {nt(NT_EQUALITY), nt(NT_AND_REST)}),
+    binaryRule(NT_AND_REST, T_BIT_AND, NT_EQUALITY),
+    rule(NT_AND_REST, {}),
+    rule(NT_EQUALITY, {nt(NT_RELATION), nt(NT_EQUALITY_REST)}),
+    binaryRule(NT_EQUALITY_REST, T_EQ, NT_RELATION),
+    binaryRule(NT_EQUALITY_REST, T_NE, NT_RELATION),
+    rule(NT_EQUALITY_REST, {}),
+    rule(NT_RELATION, {nt(NT_SHIFT), nt(NT_RELATION_REST)}),
+    binaryRule(NT_RELATION_REST, T_LT, NT_SHIFT),
+    binaryRule(NT_RELATION_REST, T_LE, NT_SHIFT),
+    binaryRule(NT_RELATION_REST, T_GT, NT_SHIFT),
+    binaryRule(NT_RELATION_REST, T_GE, NT_SHIFT),
+    rule(NT_RELATION_REST, {}),
+    rule(NT_SHIFT, {nt(NT_ADD), nt(NT_SHIFT_REST)}),
+    binaryRule(NT_SHIFT_REST, T_LSHIFT, NT_ADD),
+    binaryRule(NT_SHIFT_REST, T_RSHIFT, NT_ADD),
+    rule(NT_SHIFT_REST, {}),
+    rule(NT_ADD, {nt(NT_MUL), nt(NT_ADD_REST)}),
+    binaryRule(NT_ADD_REST, T_PLUS, NT_MUL),
+    binaryRule(NT_ADD_REST, T_MINUS, NT_MUL),
+    rule(NT_ADD_REST, {}),
+    rule(NT_MUL, {nt(NT_UNARY), nt(NT_MUL_REST)}),
+    binaryRule(NT_MUL_REST, T_MUL, NT_UNARY),
+    binaryRule(NT_MUL_REST, T_DIV, NT_UNARY),
+    binaryRule(NT_MUL_REST, T_MOD, NT_UNARY),
+    rule(NT_MUL_REST, {}),
+    rule(NT_UNARY, {T_PLUS, act(ACT_OP), nt(NT_E), act(ACT_UNARY)}),
+    rule(NT_UNARY, {T_MINUS, act(ACT_OP), nt(NT_E), act(ACT_UNARY)}),
+    rule(NT_UNARY, {nt(NT_E)}),
+    rule(NT_E, {T_LPAREN, nt(NT_V), T_RPAREN}),
+    rule(NT_E, {act(ACT_NAME), nt(NT_NAME)}),
+    rule(NT_E, {nt(NT_C)}),
+    rule(NT_C, {T_DEC_CONST, act(ACT_CONST)}),
+    rule(NT_C, {T_HEX_CONST, act(ACT_CONST)}),
+    rule(NT_C, {T_FLOAT_CONST, act(ACT_CONST)}),
+    rule(NT_C, {T_CHAR_CONST, act(ACT_CONST)}),
+};
+
+static_assert(grammar_rules[0].lhs == NT_S && grammar_rules[1].lhs != NT_S, "Разбор начинается с единственного правила S");
+
+const size_t GRAMMAR_RULE_COUNT = sizeof(grammar_rules) / sizeof(grammar_rules[0]);
+const uint8_t NO_RULE = 0xFF;
+static_assert(GRAMMAR_RULE_COUNT < NO_RULE, "Номера правил не помещаются в байт");
+
+// Таблица предсказаний: правило для нетерминала и текущей лексемы
+struct PredictTable {
+    uint8_t rule[NT_COUNT][GRAMMAR_TERMINALS];
+    uint64_t first[NT_COUNT];   // Маски терминалов
+    uint64_t follow[NT_COUNT];
+    bool nullable[NT_COUNT];
+    bool conflict;              // Два правила на одну клетку
+    bool undefined;             // Нетерминал без правил
+};
+
+// FIRST цепочки symbols[from...length); all_nullable - цепочка выводит ε
+constexpr uint64_t firstOfSequence(const GrammarRule& r, size_t from, const PredictTable& t, bool& all_nullable) {
+    uint64_t set = 0;
+    all_nullable = true;
+    for (size_t i = from; i < r.length; ++i) {
+        GrammarSymbol s = r.rhs[i];
+        if (isTerminal(s)) {
+            set |= uint64_t(1) << s;
+            all_nullable = false;
+            return set;
+        }
+        if (isNonterminal(s)) {
+            size_t n = s - GRAMMAR_NONTERMINAL_BASE;
+            set |= t.first[n];
+            if (!t.nullable[n]) {
+                all_nullable = false;
+                return set;
+            }
+        }
+        // Действия прозрачны
+    }
+    return set;
+}
+
+constexpr PredictTable buildPredictTable() {
+    PredictTable t{};
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const GrammarRule& r : grammar_rules) {
+            bool nullable = false;
+            uint64_t first = firstOfSequence(r, 0, t, nullable);
+            if ((t.first[r.lhs] | first) != t.first[r.lhs] || (nullable && !t.nullable[r.lhs])) {
+                t.first[r.lhs] |= first;
+                t.nullable[r.lhs] = t.nullable[r.lhs] || nullable;
+                changed = true;
+            }
+        }
+    }
+
+    changed = true;
+    while (changed) {
+        changed = false;
+        for (const GrammarRule& r : grammar_rules) {
+            for (size_t i = 0; i < r.length; ++i) {
+                if (!isNonterminal(r.rhs[i])) continue;
+                size_t n = r.rhs[i] - GRAMMAR_NONTERMINAL_BASE;
+                bool rest_nullable = false;
+                uint64_t follow = firstOfSequence(r, i + 1, t, rest_nullable);
+                if (rest_nullable) follow |= t.follow[r.lhs];
+                if ((t.follow[n] | follow) != t.follow[n]) {
+                    t.follow[n] |= follow;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    for (size_t n = 0; n < NT_COUNT; ++n) {
+        for (size_t k = 0; k < GRAMMAR_TERMINALS; ++k) t.rule[n][k] = NO_RULE;
+    }
+    bool defined[NT_COUNT] = {};
+    for (size_t i = 0; i < GRAMMAR_RULE_COUNT; ++i) {
+        const GrammarRule& r = grammar_rules[i];
+        defined[r.lhs] = true;
+        bool nullable = false;
+        uint64_t predict = firstOfSequence(r, 0, t, nullable);
+        if (nullable) predict |= t.follow[r.lhs];
+        for (size_t k = 0; k < GRAMMAR_TERMINALS; ++k) {
+            if ((predict & (uint64_t(1) << k)) == 0) continue;
+            if (t.rule[r.lhs][k] != NO_RULE) t.conflict = true;
+            t.rule[r.lhs][k] = static_cast<uint8_t>(i);
+        }
+    }
+    for (size_t n = 0; n < NT_COUNT; ++n) {
+        if (!defined[n]) t.undefined = true;
+    }
+    return t;
+}
+
+constexpr PredictTable predict_table = buildPredictTable();
+static_assert(!predict_table.conflict, "Грамматика не LL(1): два правила на одну клетку таблицы предсказаний");
+static_assert(!predict_table.undefined, "У нетерминала нет правил");
+
+#endif // GRAMMAR_H
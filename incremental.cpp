@@ -0,0 +1,244 @@
+#include "incremental.h"
+#include "utf8.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// Вид глобального символа: категория, тип, типы параметров. Описание,
+// использующее имя, проверяется заново, только если вид символа изменился.
+std::string symbolShape(const Symbol* sym) {
+    std::string shape;
+    shape += static_cast<char>('0' + sym->category);
+    shape += static_cast<char>('0' + sym->type);
+    if (sym->category == CAT_FUNCTION) {
+        for (int i = 0; i < sym->func_info.param_count; ++i) {
+            shape += static_cast<char>('0' + sym->func_info.params[i].type);
+        }
+    }
+    return shape;
+}
+
+typedef std::vector<std::pair<Atom, std::string>> Signatures;
+
+void appendSignatures(Signatures& all, std::vector<TopLevelDecl>::const_iterator from,
+                      std::vector<TopLevelDecl>::const_iterator to) {
+    for (; from != to; ++from) {
+        all.insert(all.end(), from->signatures.begin(), from->signatures.end());
+    }
+}
+
+// Имена, чьи символы есть только в одном из двух разборов
+void collectChanged(Signatures before, Signatures after, std::unordered_set<Atom>& changed) {
+    std::sort(before.begin(), before.end());
+    std::sort(after.begin(), after.end());
+    Signatures diff;
+    std::set_symmetric_difference(before.begin(), before.end(), after.begin(), after.end(),
+                                  std::back_inserter(diff));
+    for (const auto& sig : diff) changed.insert(sig.first);
+}
+
+bool dependsOn(const TopLevelDecl& decl, const std::unordered_set<Atom>& changed) {
+    for (Atom name : decl.uses) {
+        if (changed.count(name) != 0) return true;
+    }
+    return false;
+}
+
+bool isContinuationByte(const std::string& text, size_t pos) {
+    return pos < text.size() && (static_cast<unsigned char>(text[pos]) & 0xC0) == 0x80;
+}
+
+} // namespace
+
+IncrementalParser::IncrementalParser(std::string_view source, bool utf8)
+    : text(source), utf8(utf8), scanner(new Scanner(text, &atom_table, utf8)), parser(scanner.get()),
+      reparsed(0), rechecked(0) {
+    parser.getDiagnostics().setWarnings(false);
+    parser.setLevel(PARSE_CHECK); // Дерево описаний не нужно: нужны символы и сообщения
+    std::unordered_set<Atom> changed;
+    reparse(0, 0, 0, changed);
+}
+
+IncrementalParser::~IncrementalParser() {
+    // Символы принадлежат анализатору парсера и удаляются вместе с ним
+}
+
+void IncrementalParser::edit(size_t offset, size_t length, std::string_view replacement) {
+    if (offset > text.size()) offset = text.size();
+    if (length > text.size() - offset) length = text.size() - offset;
+    if (utf8) {
+        requireValidUtf8(replacement);
+        if (isContinuationByte(text, offset) || isContinuationByte(text, offset + length)) {
+            throw std::runtime_error("Правка разрезает символ UTF-8.");
+        }
+    }
+    size_t edit_end = offset + length;
+    text.replace(offset, length, replacement.data(), replacement.size());
+
+    // Первое задетое описание - последнее, начинающееся до правки: правка
+    // сразу за ним может изменить и его конец (пропуск лексем после ошибки)
+    auto by_begin = [](const TopLevelDecl& decl, size_t pos) { return decl.begin < pos; };
+    size_t first = std::lower_bound(decls.begin(), decls.end(), offset, by_begin) - decls.begin();
+    size_t start = 0;
+    if (first > 0) {
+        first--;
+        start = decls[first].begin;
+    }
+
+    // Описания целиком за правкой сдвигаются и могут быть переиспользованы
+    size_t reusable = std::lower_bound(decls.begin(), decls.end(), edit_end, by_begin) - decls.begin();
+    size_t delta = replacement.size() - length; // По модулю 2^N: сдвиг может быть отрицательным
+    for (size_t i = reusable; i < decls.size(); ++i) {
+        decls[i].begin += delta;
+        decls[i].end += delta;
+        for (Diagnostic& d : decls[i].errors) {
+            if (d.loc != NO_SOURCE_LOC) d.loc = static_cast<SourceLoc>(d.loc + delta);
+        }
+    }
+
+    reparsed = 0;
+    rechecked = 0;
+    std::unordered_set<Atom> changed;
+    size_t next = reparse(first, start, reusable, changed);
+
+    // Зависимые описания: их текст не изменился, изменились символы, которые они искали
+    while (next < decls.size() && !changed.empty()) {
+        if (dependsOn(decls[next], changed)) {
+            rechecked++;
+            next = reparse(next, decls[next].begin, next + 1, changed);
+        } else {
+            next++;
+        }
+    }
+}
+
+// Разбор описаний с позиции start вместо decls[first...]: идёт, пока начало
+// очередного описания не совпадёт с началом одного из decls[reusable...].
+// Возвращает индекс первого переиспользованного описания.
+size_t IncrementalParser::reparse(size_t first, size_t start, size_t reusable,
+                                  std::unordered_set<Atom>& changed) {
+    SemanticAnalyzer& analyzer = parser.getAnalyzer();
+    DiagnosticSink& sink = parser.getDiagnostics();
+
+    // Описания видят только символы тех, что стоят раньше них
+    Symbol* tail = tailBefore(first);
+    Symbol* old_chain = analyzer.detachGlobalsAfter(tail);
+
+    scanner.reset(new Scanner(text, &atom_table, utf8));
+    scanner->putUK(start);
+    parser.restart(scanner.get());
+
+    auto by_begin = [](const TopLevelDecl& decl, size_t pos) { return decl.begin < pos; };
+    std::vector<TopLevelDecl> fresh;
+    size_t resume = decls.size();
+    while (true) {
+        size_t pos = parser.currentLoc();
+        auto old = std::lower_bound(decls.begin() + std::max(reusable, first), decls.end(), pos, by_begin);
+        if (old != decls.end() && old->begin == pos) {
+            resume = old - decls.begin();
+            break;
+        }
+
+        TopLevelDecl decl{pos, 0, nullptr, nullptr, {}, {}, {}};
+        sink.clear();
+        analyzer.setGlobalLookupLog(&decl.uses);
+        bool parsed = parser.parseTopLevel();
+        analyzer.setGlobalLookupLog(nullptr);
+        if (!parsed) break;
+
+        decl.end = parser.currentLoc();
+        std::sort(decl.uses.begin(), decl.uses.end());
+        decl.uses.erase(std::unique(decl.uses.begin(), decl.uses.end()), decl.uses.end());
+        Symbol* new_tail = analyzer.lastGlobal(tail);
+        if (new_tail != tail) {
+            decl.first_symbol = analyzer.nextGlobal(tail);
+            decl.last_symbol = new_tail;
+            for (Symbol* sym = decl.first_symbol; sym != nullptr; sym = sym->next) {
+                if (sym->name != ATOM_NONE) decl.signatures.push_back({sym->name, symbolShape(sym)});
+            }
+            tail = new_tail;
+        }
+        decl.errors = sink.getErrors();
+        fresh.push_back(std::move(decl));
+    }
+    if (!fresh.empty() && resume == decls.size()) fresh.back().end = text.size();
+    reparsed += fresh.size();
+
+    // Символы заменённых описаний - начало отрезанной цепочки до символов
+    // первого переиспользованного
+    Symbol* keep = nullptr;
+    for (size_t i = resume; i < decls.size() && keep == nullptr; ++i) keep = decls[i].first_symbol;
+    if (old_chain != keep) {
+        Symbol* last_old = old_chain;
+        while (last_old->next != keep) last_old = last_old->next;
+        last_old->next = nullptr;
+        analyzer.deleteSymbols(old_chain);
+    }
+    analyzer.appendGlobals(keep);
+
+    Signatures before, after;
+    appendSignatures(before, decls.begin() + first, decls.begin() + resume);
+    appendSignatures(after, fresh.begin(), fresh.end());
+    collectChanged(std::move(before), std::move(after), changed);
+
+    // Обычно описаний столько же, сколько было: они заменяются на месте, и
+    // хвост массива не сдвигается
+    size_t common = std::min(fresh.size(), resume - first);
+    std::move(fresh.begin(), fresh.begin() + common, decls.begin() + first);
+    decls.erase(decls.begin() + first + common, decls.begin() + resume);
+    decls.insert(decls.begin() + first + common, std::make_move_iterator(fresh.begin() + common),
+                 std::make_move_iterator(fresh.end()));
+    return first + fresh.size();
+}
+
+// Последний глобальный символ описаний до index
+Symbol* IncrementalParser::tailBefore(size_t index) const {
+    for (size_t i = index; i > 0; --i) {
+        if (decls[i - 1].last_symbol != nullptr) return decls[i - 1].last_symbol;
+    }
+    return nullptr;
+}
+
+size_t IncrementalParser::lineOffset(size_t line) const {
+    size_t pos = 0;
+    for (size_t i = 1; i < line; ++i) {
+        const void* nl = std::memchr(text.data() + pos, '\n', text.size() - pos);
+        if (nl == nullptr) return text.size();
+        pos = static_cast<const char*>(nl) - text.data() + 1;
+    }
+    return pos;
+}
+
+const std::string& IncrementalParser::getText() const {
+    return text;
+}
+
+size_t IncrementalParser::declarationCount() const {
+    return decls.size();
+}
+
+size_t IncrementalParser::getReparsedCount() const {
+    return reparsed;
+}
+
+size_t IncrementalParser::getRecheckedCount() const {
+    return rechecked;
+}
+
+size_t IncrementalParser::errorCount() const {
+    size_t count = 0;
+    for (const TopLevelDecl& decl : decls) count += decl.errors.size();
+    return count;
+}
+
+void IncrementalParser::printDiagnostics(std::ostream& out) const {
+    const SourceMap& map = scanner->getSourceMap();
+    for (const TopLevelDecl& decl : decls) {
+        for (const Diagnostic& d : decl.errors) DiagnosticSink::printError(out, d, map);
+    }
+    size_t count = errorCount();
+    if (count > 1) out << "Найдено ошибок: " << count << '\n';
+    out.flush();
+}
@@ -0,0 +1,75 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "diagnostics.h"
+#include "intern.h"
+#include "parser.h"
+#include "scanner.h"
+
+// Описание верхнего уровня (или ошибочный участок между описаниями)
+// с результатами своего разбора
+struct TopLevelDecl {
+    size_t begin;                  // Смещение первой лексемы
+    size_t end;                    // Начало следующего описания (или конец текста)
+    Symbol* first_symbol;          // Свой отрезок цепочки глобальной области
+    Symbol* last_symbol;           // (nullptr, если описание ничего не добавило)
+    std::vector<Atom> uses;        // Имена, искавшиеся в глобальной области
+    std::vector<std::pair<Atom, std::string>> signatures; // Добавленные символы: имя и вид (категория, типы)
+    std::vector<Diagnostic> errors;
+};
+
+// Инкрементальный разбор: текст программы, разбитый на описания верхнего
+// уровня, и результаты разбора каждого. Правка текста перечитывает только
+// описания, которые она задевает: разбор идёт с начала первого задетого
+// описания, пока начало очередного описания не совпадёт с началом старого
+// описания за правкой (как склейка кусков в TokenBuffer); дальше старые
+// описания переиспользуются вместе с их символами и сообщениями.
+// Описание за правкой проверяется заново, если оно искало в глобальной
+// области имя, символ которого появился, исчез или изменил тип.
+//
+// Предупреждения в этом режиме не выводятся: признак инициализации
+// глобальной переменной меняют и последующие описания.
+class IncrementalParser {
+public:
+    // Полный разбор source (текст копируется)
+    explicit IncrementalParser(std::string_view source, bool utf8 = false);
+    ~IncrementalParser();
+
+    IncrementalParser(const IncrementalParser&) = delete;
+    IncrementalParser& operator=(const IncrementalParser&) = delete;
+
+    // Заменить length байт с позиции offset на replacement и перепроверить
+    // затронутые описания
+    void edit(size_t offset, size_t length, std::string_view replacement);
+    // Смещение начала строки line (с 1); за концом текста - длина текста
+    size_t lineOffset(size_t line) const;
+
+    const std::string& getText() const;
+    size_t declarationCount() const;
+    size_t getReparsedCount() const;   // Описаний, перечитанных последней правкой
+    size_t getRecheckedCount() const;  // Из них зависимых, а не задетых правкой
+    size_t errorCount() const;
+    void printDiagnostics(std::ostream& out) const;
+
+private:
+    std::string text;
+    bool utf8;
+    std::vector<TopLevelDecl> decls;
+    std::unique_ptr<Scanner> scanner;  // Сканер текущего текста
+    Parser parser;
+    size_t reparsed;
+    size_t rechecked;
+
+    size_t reparse(size_t first, size_t start, size_t reusable, std::unordered_set<Atom>& changed);
+    Symbol* tailBefore(size_t index) const;
+};
+
+#endif // INCREMENTAL_H
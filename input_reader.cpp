@@ -0,0 +1,200 @@
+#include "input_reader.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#ifdef TRANSLATOR_GZIP
+#include <zlib.h>
+#endif
+#ifdef TRANSLATOR_ZSTD
+#include <zstd.h>
+#endif
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+const size_t INPUT_RAW_BUFFER_SIZE = 64 * 1024; // Порция сжатых данных
+
+InputFormat detectInputFormat(std::string_view head) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(head.data());
+    if (head.length() >= 2 && p[0] == 0x1f && p[1] == 0x8b) return INPUT_GZIP;
+    if (head.length() >= 4 && p[0] == 0x28 && p[1] == 0xb5 && p[2] == 0x2f && p[3] == 0xfd) return INPUT_ZSTD;
+    return INPUT_PLAIN;
+}
+
+InputReader::InputReader(int fd)
+    : fd(fd), started(false), raw_eof(false), finished(false), input_format(INPUT_PLAIN),
+      raw_pos(0), raw_end(0), decoder(nullptr), frame_done(false) {
+}
+
+InputReader::~InputReader() {
+    if (decoder == nullptr) return;
+#ifdef TRANSLATOR_GZIP
+    if (input_format == INPUT_GZIP) {
+        z_stream* zs = static_cast<z_stream*>(decoder);
+        inflateEnd(zs);
+        delete zs;
+    }
+#endif
+#ifdef TRANSLATOR_ZSTD
+    if (input_format == INPUT_ZSTD) ZSTD_freeDStream(static_cast<ZSTD_DStream*>(decoder));
+#endif
+}
+
+InputFormat InputReader::format() const {
+    return input_format;
+}
+
+size_t InputReader::readRaw(char* buffer, size_t size) {
+    long got;
+    do {
+#ifdef _WIN32
+        got = _read(fd, buffer, static_cast<unsigned>(size));
+#else
+        got = ::read(fd, buffer, size);
+#endif
+    } while (got < 0 && errno == EINTR);
+    if (got < 0) {
+        throw std::runtime_error(std::string("Ошибка чтения входного потока: ") + std::strerror(errno));
+    }
+    return static_cast<size_t>(got);
+}
+
+bool InputReader::fillRaw() {
+    if (raw_pos < raw_end) return true;
+    if (raw_eof) return false;
+    raw_pos = 0;
+    raw_end = readRaw(raw.data(), raw.size());
+    raw_eof = raw_end == 0;
+    return !raw_eof;
+}
+
+// Первое чтение: магические байты (4 байта могут прийти по частям из pipe)
+void InputReader::start() {
+    started = true;
+    raw.resize(INPUT_RAW_BUFFER_SIZE);
+    while (raw_end < 4 && !raw_eof) {
+        size_t got = readRaw(raw.data() + raw_end, raw.size() - raw_end);
+        raw_end += got;
+        raw_eof = got == 0;
+    }
+    input_format = detectInputFormat(std::string_view(raw.data(), raw_end));
+
+    if (input_format == INPUT_GZIP) {
+#ifdef TRANSLATOR_GZIP
+        z_stream* zs = new z_stream();
+        // 15 + 32: окно 32 КБ, заголовок gzip или zlib определяется автоматически
+        if (inflateInit2(zs, 15 + 32) != Z_OK) {
+            delete zs;
+            throw std::runtime_error("Не удалось инициализировать распаковку gzip.");
+        }
+        decoder = zs;
+#else
+        throw std::runtime_error("Вход сжат gzip, но транслятор собран без поддержки gzip (make GZIP=1).");
+#endif
+    } else if (input_format == INPUT_ZSTD) {
+#ifdef TRANSLATOR_ZSTD
+        ZSTD_DStream* ds = ZSTD_createDStream();
+        if (ds == nullptr || ZSTD_isError(ZSTD_initDStream(ds))) {
+            ZSTD_freeDStream(ds);
+            throw std::runtime_error("Не удалось инициализировать распаковку zstd.");
+        }
+        decoder = ds;
+#else
+        throw std::runtime_error("Вход сжат zstd, но транслятор собран без поддержки zstd (make ZSTD=1).");
+#endif
+    }
+}
+
+size_t InputReader::read(char* buffer, size_t size) {
+    if (!started) start();
+    if (finished || size == 0) return 0;
+
+    switch (input_format) {
+        case INPUT_GZIP:
+            return inflateGzip(buffer, size);
+        case INPUT_ZSTD:
+            return decompressZstd(buffer, size);
+        default:
+            break;
+    }
+
+    // Несжатый вход: сначала байты, прочитанные для определения формата
+    if (raw_pos < raw_end) {
+        size_t n = std::min(size, raw_end - raw_pos);
+        std::memcpy(buffer, raw.data() + raw_pos, n);
+        raw_pos += n;
+        return n;
+    }
+    size_t got = raw_eof ? 0 : readRaw(buffer, size);
+    finished = got == 0;
+    return got;
+}
+
+// Распаковка до получения хотя бы одного байта. Вход может кончиться, пока
+// распаковщик ещё отдаёт накопленные данные, поэтому он вызывается и без входа.
+size_t InputReader::inflateGzip(char* buffer, size_t size) {
+#ifdef TRANSLATOR_GZIP
+    z_stream* zs = static_cast<z_stream*>(decoder);
+    zs->next_out = reinterpret_cast<Bytef*>(buffer);
+    zs->avail_out = static_cast<uInt>(size);
+    while (zs->avail_out == size) {
+        bool have_input = fillRaw();
+        zs->next_in = reinterpret_cast<Bytef*>(raw.data() + raw_pos);
+        zs->avail_in = static_cast<uInt>(raw_end - raw_pos);
+        int rc = inflate(zs, Z_NO_FLUSH);
+        raw_pos = raw_end - zs->avail_in;
+        if (rc == Z_STREAM_END) {
+            // Файл из нескольких склеенных gzip-членов продолжается следующим
+            if (fillRaw()) {
+                inflateReset(zs);
+                continue;
+            }
+            finished = true;
+            break;
+        }
+        if (rc == Z_BUF_ERROR && !have_input) {
+            throw std::runtime_error("Сжатый вход gzip обрывается до конца данных.");
+        }
+        if (rc != Z_OK && rc != Z_BUF_ERROR) {
+            throw std::runtime_error(std::string("Повреждённые данные gzip: ") +
+                                     (zs->msg != nullptr ? zs->msg : "ошибка распаковки"));
+        }
+    }
+    return size - zs->avail_out;
+#else
+    (void)buffer;
+    (void)size;
+    return 0;
+#endif
+}
+
+size_t InputReader::decompressZstd(char* buffer, size_t size) {
+#ifdef TRANSLATOR_ZSTD
+    ZSTD_DStream* ds = static_cast<ZSTD_DStream*>(decoder);
+    ZSTD_outBuffer out = {buffer, size, 0};
+    while (out.pos == 0) {
+        bool have_input = fillRaw();
+        ZSTD_inBuffer in = {raw.data() + raw_pos, raw_end - raw_pos, 0};
+        size_t rest = ZSTD_decompressStream(ds, &out, &in);
+        raw_pos += in.pos;
+        if (ZSTD_isError(rest)) {
+            throw std::runtime_error(std::string("Повреждённые данные zstd: ") + ZSTD_getErrorName(rest));
+        }
+        if (in.pos > 0 || out.pos > 0) frame_done = rest == 0; // 0 - кадр полностью выдан
+        if (!have_input && out.pos == 0) {
+            if (!frame_done) throw std::runtime_error("Сжатый вход zstd обрывается до конца данных.");
+            finished = true;
+            break;
+        }
+    }
+    return out.pos;
+#else
+    (void)buffer;
+    (void)size;
+    return 0;
+#endif
+}
@@ -0,0 +1,55 @@
+#ifndef INPUT_READER_H
+#define INPUT_READER_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Форматы входа, определяемые по первым байтам
+enum InputFormat {
+    INPUT_PLAIN,
+    INPUT_GZIP, // 1f 8b (нужна сборка с GZIP=1)
+    INPUT_ZSTD  // 28 b5 2f fd (нужна сборка с ZSTD=1)
+};
+
+// Формат по началу данных (достаточно 4 байт)
+InputFormat detectInputFormat(std::string_view head);
+
+// Источник байтов для потокового сканера: читает дескриптор и, если вход
+// сжат gzip или zstd, распаковывает его на лету прямо в буфер вызывающего.
+// Формат определяется по магическим байтам при первом чтении; временных
+// файлов и полного буфера распакованного текста нет.
+class InputReader {
+public:
+    explicit InputReader(int fd = -1);
+    ~InputReader();
+
+    InputReader(const InputReader&) = delete;
+    InputReader& operator=(const InputReader&) = delete;
+
+    // До size байт распакованного текста в buffer; 0 - конец входа.
+    // Ошибки чтения и повреждённые сжатые данные - std::runtime_error.
+    size_t read(char* buffer, size_t size);
+
+    InputFormat format() const;
+
+private:
+    int fd;
+    bool started;            // Формат уже определён
+    bool raw_eof;            // Дескриптор исчерпан
+    bool finished;           // Конец распакованных данных
+    InputFormat input_format;
+    std::vector<char> raw;   // Сжатые данные, ещё не отданные распаковщику
+    size_t raw_pos;
+    size_t raw_end;
+    void* decoder;           // z_stream или ZSTD_DStream
+    bool frame_done;         // zstd: последний кадр выдан целиком
+
+    void start();
+    size_t readRaw(char* buffer, size_t size);  // read() с повтором при EINTR
+    bool fillRaw();                              // Дочитать сжатые данные; false - конец
+    size_t inflateGzip(char* buffer, size_t size);
+    size_t decompressZstd(char* buffer, size_t size);
+};
+
+#endif // INPUT_READER_H
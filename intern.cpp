@@ -0,0 +1,67 @@
+#include "intern.h"
+#include <cstring>
+
+AtomTable atom_table;
+
+const size_t ATOM_BLOCK_SIZE = 64 * 1024;
+
+AtomTable::AtomTable() : slots(1024, ATOM_NONE), block_used(0), block_size(0) {
+    names.push_back(std::string_view()); // ATOM_NONE
+}
+
+// FNV-1a
+uint64_t AtomTable::hash(std::string_view name) {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : name) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Копия текста имени в арену; длинные имена получают собственный блок
+std::string_view AtomTable::store(std::string_view name) {
+    if (block_used + name.length() > block_size) {
+        block_size = name.length() > ATOM_BLOCK_SIZE ? name.length() : ATOM_BLOCK_SIZE;
+        blocks.emplace_back(new char[block_size]);
+        block_used = 0;
+    }
+    char* dst = blocks.back().get() + block_used;
+    if (!name.empty()) std::memcpy(dst, name.data(), name.length());
+    block_used += name.length();
+    return std::string_view(dst, name.length());
+}
+
+void AtomTable::grow() {
+    std::vector<Atom> bigger(slots.size() * 2, ATOM_NONE);
+    size_t mask = bigger.size() - 1;
+    for (Atom atom = 1; atom < names.size(); ++atom) {
+        size_t i = hash(names[atom]) & mask;
+        while (bigger[i] != ATOM_NONE) i = (i + 1) & mask;
+        bigger[i] = atom;
+    }
+    slots.swap(bigger);
+}
+
+Atom AtomTable::intern(std::string_view name) {
+    size_t mask = slots.size() - 1;
+    size_t i = hash(name) & mask;
+    while (slots[i] != ATOM_NONE) {
+        if (names[slots[i]] == name) return slots[i];
+        i = (i + 1) & mask;
+    }
+
+    Atom atom = static_cast<Atom>(names.size());
+    names.push_back(store(name));
+    slots[i] = atom;
+    if (names.size() * 2 > slots.size()) grow(); // Заполненность не больше половины
+    return atom;
+}
+
+std::string_view AtomTable::name(Atom atom) const {
+    return names[atom];
+}
+
+size_t AtomTable::size() const {
+    return names.size();
+}
@@ -0,0 +1,41 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Атом - 32-битный номер интернированного имени. Одинаковые имена получают
+// один и тот же атом, поэтому имена сравниваются как целые числа.
+typedef uint32_t Atom;
+const Atom ATOM_NONE = 0; // Нет имени (не идентификатор, узел области видимости)
+
+// Таблица интернирования: открытая адресация по хешу имени, тексты имён
+// хранятся в блоках-аренах и не перемещаются. Не потокобезопасна; но
+// intern уже внесённого имени таблицу не меняет, поэтому заполненную
+// таблицу могут одновременно читать несколько потоков (см. ParallelParser).
+class AtomTable {
+public:
+    AtomTable();
+
+    Atom intern(std::string_view name);       // Атом имени (создаётся при первом обращении)
+    std::string_view name(Atom atom) const;   // Текст имени атома
+    size_t size() const;                      // Число атомов, включая ATOM_NONE
+
+private:
+    std::vector<std::string_view> names;      // Индекс - атом
+    std::vector<Atom> slots;                  // Хеш-таблица: атом или ATOM_NONE
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t block_used;
+    size_t block_size;
+
+    static uint64_t hash(std::string_view name);
+    std::string_view store(std::string_view name);
+    void grow();
+};
+
+// Общая таблица атомов транслятора
+extern AtomTable atom_table;
+
+#endif // INTERN_H
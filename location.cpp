@@ -0,0 +1,39 @@
+#include "location.h"
+#include <algorithm>
+#include <cstring>
+
+SourceMap::SourceMap() : source_code(), loc_is_offset(false), index_built(true) {
+}
+
+SourceMap::SourceMap(std::string_view source)
+    : source_code(source), loc_is_offset(true), index_built(false) {
+}
+
+void SourceMap::buildIndex() const {
+    const char* begin = source_code.data();
+    const char* end = begin + source_code.length();
+    for (const char* p = begin; p < end; ++p) {
+        // memchr в libc векторизован, поэтому проход идёт блоками, а не по символу
+        p = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (p == nullptr) break;
+        line_starts.push_back(static_cast<uint32_t>(p - begin + 1));
+    }
+    index_built = true;
+}
+
+LineCol SourceMap::decode(SourceLoc loc) const {
+    if (!loc_is_offset) return {loc, 0};
+    if (!index_built) buildIndex();
+    // Число начал строк не правее loc - это номер строки минус один
+    auto it = std::upper_bound(line_starts.begin(), line_starts.end(), loc);
+    uint32_t line = static_cast<uint32_t>(it - line_starts.begin()) + 1;
+    uint32_t line_start = (it == line_starts.begin()) ? 0 : *(it - 1);
+    return {line, loc - line_start + 1};
+}
+
+std::string SourceMap::describe(SourceLoc loc) const {
+    LineCol lc = decode(loc);
+    std::string text = "строке " + std::to_string(lc.line);
+    if (lc.column != 0) text += ", столбце " + std::to_string(lc.column);
+    return text;
+}
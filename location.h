@@ -0,0 +1,38 @@
+#ifndef LOCATION_H
+#define LOCATION_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Компактная позиция в исходном тексте: 32-битное смещение от начала файла.
+// В потоковом режиме (файл целиком недоступен) позиция - номер строки.
+typedef uint32_t SourceLoc;
+
+struct LineCol {
+    uint32_t line;
+    uint32_t column; // 0, если столбец неизвестен (потоковый режим)
+};
+
+// Преобразование позиций в строку:столбец. Индекс начал строк строится
+// одним проходом memchr только при первом запросе - то есть когда нужно
+// выдать диагностику; успешный разбор его не строит вовсе.
+class SourceMap {
+public:
+    SourceMap();                                  // Позиции - номера строк
+    explicit SourceMap(std::string_view source);  // Позиции - смещения в source
+
+    LineCol decode(SourceLoc loc) const;          // O(log n) после построения индекса
+    std::string describe(SourceLoc loc) const;    // "строке 3, столбце 7"
+
+private:
+    std::string_view source_code;
+    bool loc_is_offset;
+    mutable bool index_built;
+    mutable std::vector<uint32_t> line_starts;    // Смещения начал строк (кроме первой)
+
+    void buildIndex() const;
+};
+
+#endif // LOCATION_H
@@ -1,8 +1,25 @@
-#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <fstream>
-#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#endif
+#include "source.h"
 #include "scanner.h"
+#include "token_buffer.h"
+#include "token_queue.h"
+#include "utf8.h"
+#include "input_reader.h"
 #include "parser.h"
+#include "incremental.h"
+#include "parallel_parser.h"
+#include "virtual_machine.h"
 
 // Функция для удобного вывода имени токена
 std::string tokenTypeToString(TokenType type) {
@@ -49,30 +66,311 @@ std::string tokenTypeToString(TokenType type) {
     }
 }
 
+// Правка из файла --edits: заменить count строк начиная со строки line
+struct LineEdit {
+    size_t line;
+    size_t count;
+    std::string text;
+};
+
+// Файл правок: блоки "@@ СТРОКА ЧИСЛО", за заголовком - новые строки
+// до следующего заголовка
+bool readEdits(const char* path, std::vector<LineEdit>& edits) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind("@@ ", 0) == 0) {
+            char* end = nullptr;
+            LineEdit edit;
+            edit.line = std::strtoul(line.c_str() + 3, &end, 10);
+            edit.count = std::strtoul(end, nullptr, 10);
+            if (edit.line == 0) return false;
+            edits.push_back(edit);
+        } else if (edits.empty()) {
+            return false;
+        } else {
+            edits.back().text += line;
+            edits.back().text += '\n';
+        }
+    }
+    return true;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Режим --lex-only: все лексемы до конца входа, ошибочные - в diagnostics
+template <typename NextToken>
+void lexAll(NextToken next, DiagnosticSink& diagnostics) {
+    for (Token token = next(); token.type != T_EOF; token = next()) {
+        if (token.type == T_ERROR) {
+            diagnostics.error(token.loc, "Недопустимая лексема\n\tНа ", ", получен токен: \"" + std::string(token.text) + "\"");
+        }
+    }
+}
+
+// Пропускная способность режимов --lex-only, --syntax-only и --check
+void printThroughput(const char* phase, size_t bytes, double milliseconds) {
+    double megabytes = bytes / (1024.0 * 1024.0);
+    std::cerr << phase << ": " << std::fixed << std::setprecision(2) << megabytes << " MB in "
+              << milliseconds << " ms, " << std::setprecision(1)
+              << (milliseconds > 0 ? megabytes * 1000 / milliseconds : 0.0) << " MB/s" << std::endl;
+}
+
+// Инкрементальный режим: полный разбор, затем правки по одной
+bool runEdits(std::string_view source, bool utf8, const std::vector<LineEdit>& edits) {
+    auto start = std::chrono::steady_clock::now();
+    IncrementalParser inc(source, utf8);
+    std::cerr << "Initial parse: " << inc.declarationCount() << " declarations, "
+              << millisecondsSince(start) << " ms" << std::endl;
+    for (size_t i = 0; i < edits.size(); ++i) {
+        const LineEdit& edit = edits[i];
+        start = std::chrono::steady_clock::now();
+        size_t offset = inc.lineOffset(edit.line);
+        inc.edit(offset, inc.lineOffset(edit.line + edit.count) - offset, edit.text);
+        double elapsed = millisecondsSince(start);
+        std::cerr << "Edit " << i + 1 << " (line " << edit.line << ", " << edit.count << " lines): reparsed "
+                  << inc.getReparsedCount() << " of " << inc.declarationCount() << " declarations ("
+                  << inc.getRecheckedCount() << " dependents) in " << elapsed << " ms" << std::endl;
+    }
+    inc.printDiagnostics(std::cerr);
+    return inc.errorCount() == 0;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <filename>" << std::endl;
+    bool prelex = false;       // Сначала разобрать весь файл в буфер лексем
+    bool stream = false;       // Читать вход потоком окнами фиксированного размера
+    bool pipeline = false;     // Сканер в отдельном потоке, лексемы - через очередь
+    bool utf8 = false;         // Вход в UTF-8 (идентификаторы Unicode)
+    bool print_ast = false;    // Вывести синтаксическое дерево
+    bool parallel = false;     // Тела функций - в отдельных потоках (с буфером лексем)
+    bool run = false;          // Скомпилировать за один проход в байт-код и выполнить
+    bool print_bytecode = false; // Вывести байт-код
+    bool lex_only = false;     // Только лексический анализ
+    ParseLevel level = PARSE_FULL; // --syntax-only, --check
+    unsigned threads = 0;      // Потоков для лексического разбора и тел функций (0 - по умолчанию)
+    size_t window_size = STREAM_WINDOW_SIZE;
+    const char* edits_path = nullptr; // Файл правок для инкрементального разбора
+    const char* path = nullptr;
+    bool bad_args = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--prelex") {
+            prelex = true;
+        } else if (arg == "--ast") {
+            print_ast = true;
+        } else if (arg == "--utf8") {
+            utf8 = true;
+        } else if (arg == "--parallel") {
+            parallel = true;
+            prelex = true;
+        } else if (arg == "--run") {
+            run = true;
+        } else if (arg == "--bytecode") {
+            print_bytecode = true;
+        } else if (arg == "--lex-only") {
+            lex_only = true;
+        } else if (arg == "--syntax-only") {
+            bad_args = bad_args || level != PARSE_FULL;
+            level = PARSE_SYNTAX;
+        } else if (arg == "--check") {
+            bad_args = bad_args || level != PARSE_FULL;
+            level = PARSE_CHECK;
+        } else if (arg == "--pipeline") {
+            pipeline = true;
+        } else if (arg == "--stream") {
+            stream = true;
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            threads = static_cast<unsigned>(std::strtoul(arg.c_str() + 10, nullptr, 10));
+            bad_args = bad_args || threads == 0;
+            prelex = true;
+        } else if (arg.rfind("--window=", 0) == 0) {
+            window_size = std::strtoul(arg.c_str() + 9, nullptr, 10);
+            bad_args = bad_args || window_size == 0;
+        } else if (arg.rfind("--edits=", 0) == 0) {
+            edits_path = argv[i] + 8;
+        } else if (path == nullptr) {
+            path = argv[i];
+        } else {
+            bad_args = true;
+        }
+    }
+
+    bool from_stdin = path != nullptr && std::string(path) == "-";
+    if (path == nullptr || bad_args || (prelex + (stream || from_stdin) + pipeline > 1) ||
+        (edits_path != nullptr && (prelex || stream || from_stdin || pipeline || print_ast)) ||
+        (parallel && print_ast) ||
+        ((run || print_bytecode) && (print_ast || parallel || edits_path != nullptr)) ||
+        ((lex_only || level != PARSE_FULL) &&
+         (lex_only + (level != PARSE_FULL) > 1 || print_ast || run || print_bytecode || parallel || edits_path != nullptr))) {
+        std::cerr << "Usage: " << argv[0] << " [--utf8] [--ast | --run | --bytecode] [--prelex [--threads=N] | --stream [--window=BYTES] | --pipeline] <filename | ->" << std::endl;
+        std::cerr << "       " << argv[0] << " [--utf8] --parallel [--threads=N] <filename>" << std::endl;
+        std::cerr << "       " << argv[0] << " [--utf8] --edits=EDITS <filename>" << std::endl;
+        std::cerr << "       " << argv[0] << " [--utf8] --lex-only | --syntax-only | --check [--prelex [--threads=N] | --stream [--window=BYTES] | --pipeline] <filename | ->" << std::endl;
+        std::cerr << "  '-' reads the program from standard input (always streamed)" << std::endl;
+        std::cerr << "  gzip/zstd compressed input is detected and decompressed while streaming" << std::endl;
+        std::cerr << "  --ast prints the syntax tree built by the parser" << std::endl;
+        std::cerr << "  --run compiles the program to bytecode while parsing (no tree), runs main() and prints the globals" << std::endl;
+        std::cerr << "  --bytecode prints the bytecode compiled while parsing" << std::endl;
+        std::cerr << "  --utf8 accepts UTF-8 input and Unicode (XID) identifiers" << std::endl;
+        std::cerr << "  --pipeline runs the scanner in its own thread and prints queue statistics" << std::endl;
+        std::cerr << "  --parallel parses function bodies concurrently on N threads (default: all cores)" << std::endl;
+        std::cerr << "  --lex-only stops after lexing, --syntax-only after parsing (no symbols or type checks)," << std::endl;
+        std::cerr << "    --check after semantic analysis (no tree or symbol table output); each reports MB/s" << std::endl;
+        std::cerr << "  --edits applies line edits (\"@@ LINE COUNT\" + new lines) and reparses only what they touch" << std::endl;
         return 1;
     }
 
-    std::ifstream file(argv[1]);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << argv[1] << std::endl;
+    stream = stream || from_stdin;
+    if (threads == 0) threads = parallel ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+
+    std::vector<LineEdit> edits;
+    if (edits_path != nullptr && !readEdits(edits_path, edits)) {
+        std::cerr << "Error: Could not read edits from " << edits_path << std::endl;
         return 1;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string source = buffer.str();
+    // Файл отображается в память; сканер и лексемы ссылаются прямо на него.
+    // В потоковом режиме файл не отображается, а читается через дескриптор.
+    SourceFile file;
+    int fd = -1;
+    if (!stream && !file.open(path)) {
+        std::cerr << "Error: Could not open file " << path << std::endl;
+        return 1;
+    }
+    // Сжатый файл (gzip, zstd) распаковывается на лету и поэтому всегда читается потоком
+    if (file.is_open() && detectInputFormat(file.text()) != INPUT_PLAIN) {
+        if (prelex || pipeline || edits_path != nullptr) {
+            std::cerr << "Error: " << path << " is compressed and can only be read with streaming "
+                      << "(without --prelex, --threads, --pipeline or --edits)" << std::endl;
+            return 1;
+        }
+        file.close();
+        stream = true;
+    }
+    if (from_stdin) {
+        fd = 0;
+    } else if (stream) {
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error: Could not open file " << path << std::endl;
+            return 1;
+        }
+    }
 
     try {
-        Scanner scanner(source);
-        Parser parser(&scanner);
-        parser.parse();
-        
-        std::cout << "Syntax analysis finished successfully." << std::endl;
+        // Файл в памяти проверяется целиком до разбора, поток - по мере чтения
+        if (utf8 && !stream) requireValidUtf8(file.text());
+
+        // Ошибки в программе не прерывают разбор, а копятся в парсере
+        bool failed = false;
+        CodeEmitter emitter;
+        CodeEmitter* code = run || print_bytecode ? &emitter : nullptr;
+        auto start = std::chrono::steady_clock::now();
+        size_t input_bytes = file.text().size(); // Для потока - прочитанное сканером
+        auto finish = [print_ast, &failed](const Parser& parser) {
+            if (print_ast) parser.getAst().print(std::cout);
+            if (parser.getDiagnostics().hasErrors()) {
+                std::cout.flush();
+                parser.getDiagnostics().print(std::cerr, parser.getSourceMap());
+                failed = true;
+            }
+        };
+
+        if (lex_only) {
+            DiagnosticSink lex_errors;
+            if (prelex) {
+                TokenBuffer tokens(file.text(), threads, utf8);
+                size_t index = 0;
+                lexAll([&tokens, &index]() { return tokens.token(index++); }, lex_errors);
+                if (lex_errors.hasErrors()) lex_errors.print(std::cerr, tokens.getSourceMap());
+            } else if (pipeline) {
+                TokenQueue queue(file.text(), utf8);
+                lexAll([&queue]() { return queue.pop(); }, lex_errors);
+                if (lex_errors.hasErrors()) lex_errors.print(std::cerr, queue.getSourceMap());
+            } else if (stream) {
+                Scanner scanner(fd, window_size, &atom_table, utf8);
+                lexAll([&scanner]() { return scanner.getNextToken(); }, lex_errors);
+                input_bytes = scanner.getUK();
+                if (lex_errors.hasErrors()) lex_errors.print(std::cerr, scanner.getSourceMap());
+            } else {
+                Scanner scanner(file.text(), &atom_table, utf8);
+                lexAll([&scanner]() { return scanner.getNextToken(); }, lex_errors);
+                if (lex_errors.hasErrors()) lex_errors.print(std::cerr, scanner.getSourceMap());
+            }
+            failed = lex_errors.hasErrors();
+        } else if (edits_path != nullptr) {
+            failed = !runEdits(file.text(), utf8, edits);
+        } else if (parallel) {
+            TokenBuffer tokens(file.text(), threads, utf8);
+            ParallelParser parser(&tokens, threads);
+            parser.parse();
+            if (parser.getDiagnostics().hasErrors()) {
+                std::cout.flush();
+                parser.getDiagnostics().print(std::cerr, parser.getSourceMap());
+                failed = true;
+            }
+            parser.printStats(std::cerr);
+        } else if (prelex) {
+            TokenBuffer tokens(file.text(), threads, utf8);
+            Parser parser(&tokens);
+            parser.setLevel(level);
+            parser.setEmitter(code);
+            parser.parse();
+            finish(parser);
+        } else if (pipeline) {
+            TokenQueue queue(file.text(), utf8);
+            Parser parser(&queue);
+            parser.setLevel(level);
+            parser.setEmitter(code);
+            parser.parse();
+            finish(parser);
+            queue.printStats(std::cerr);
+        } else if (stream) {
+            Scanner scanner(fd, window_size, &atom_table, utf8);
+            Parser parser(&scanner);
+            parser.setLevel(level);
+            parser.setEmitter(code);
+            parser.parse();
+            input_bytes = scanner.getUK();
+            finish(parser);
+        } else {
+            Scanner scanner(file.text(), &atom_table, utf8);
+            Parser parser(&scanner);
+            parser.setLevel(level);
+            parser.setEmitter(code);
+            parser.parse();
+            finish(parser);
+        }
+        if (lex_only || level != PARSE_FULL) {
+            static const char* const phases[] = {"Full", "Check", "Syntax only"};
+            printThroughput(lex_only ? "Lex only" : phases[level], input_bytes, millisecondsSince(start));
+        }
+        if (failed) return 1;
+
+        if (lex_only) {
+            std::cout << "Lexical analysis finished successfully." << std::endl;
+        } else if (code == nullptr) {
+            std::cout << "Syntax analysis finished successfully." << std::endl;
+        } else {
+            if (print_bytecode) emitter.getBytecode().print(std::cout);
+            if (run) {
+                VirtualMachine vm(emitter.getBytecode());
+                try {
+                    vm.run();
+                } catch (const std::runtime_error& e) {
+                    std::cout.flush();
+                    std::cerr << e.what() << std::endl;
+                    return 1;
+                }
+                vm.printGlobals(std::cout);
+            }
+        }
 
     } catch (const std::runtime_error& e) {
+        // Ошибки ввода (чтение, распаковка, некорректный UTF-8) по-прежнему прерывают работу
         std::cerr << "Syntax error: " << e.what() << std::endl;
         return 1;
     }
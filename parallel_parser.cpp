@@ -0,0 +1,153 @@
+#include "parallel_parser.h"
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Очередь тел одного потока. Свои тела поток берёт с начала очереди, чужие -
+// с конца, поэтому хозяин и вор обычно работают с разными концами.
+struct WorkQueue {
+    std::mutex lock;
+    std::deque<size_t> tasks;
+};
+
+bool takeTask(std::vector<WorkQueue>& queues, size_t self, size_t& task, size_t& stolen) {
+    {
+        std::lock_guard<std::mutex> guard(queues[self].lock);
+        if (!queues[self].tasks.empty()) {
+            task = queues[self].tasks.front();
+            queues[self].tasks.pop_front();
+            return true;
+        }
+    }
+    // Новых тел не появляется: если все очереди пусты, работа закончена
+    for (size_t k = 1; k < queues.size(); ++k) {
+        WorkQueue& victim = queues[(self + k) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            stolen++;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+ParallelParser::ParallelParser(TokenBuffer* tokens, unsigned threads)
+    : tokens(tokens), threads(std::max(1u, threads)), parser(tokens), body_count(0), stolen(0) {
+}
+
+void ParallelParser::parse() {
+    // Первый проход. Дерево в этом режиме не выводится, поэтому оба прохода
+    // его не строят
+    std::vector<DeferredBody> bodies;
+    parser.setLevel(PARSE_CHECK);
+    parser.getDiagnostics().deferWarnings(true);
+    parser.deferBodies(&bodies);
+    while (parser.parseTopLevel()) {
+    }
+    parser.deferBodies(nullptr);
+    body_count = bodies.size();
+
+    // Второй проход
+    std::vector<BodyResult> results(bodies.size());
+    parseBodies(bodies, results);
+
+    bool clean = parser.allBodiesDeferred();
+    for (const BodyResult& result : results) clean = clean && result.clean;
+    if (!clean) {
+        sequential.reset(new Parser(tokens));
+        sequential->parse();
+        return;
+    }
+
+    // Сообщения в порядке текста: первый проход до тела, тело, ..., хвост
+    const SourceMap& map = tokens->getSourceMap();
+    std::unordered_set<Atom> initialized; // Глобальные переменные, которым присваивали в телах
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        bodies[i].before.printWarnings(std::cout, map, initialized);
+        diagnostics.append(bodies[i].before);
+        results[i].diagnostics.printWarnings(std::cout, map, initialized);
+        diagnostics.append(results[i].diagnostics);
+        initialized.insert(results[i].assigned_globals.begin(), results[i].assigned_globals.end());
+    }
+    parser.getDiagnostics().printWarnings(std::cout, map, initialized);
+    diagnostics.append(parser.getDiagnostics());
+
+    if (!diagnostics.hasErrors()) parser.getAnalyzer().printTree();
+}
+
+void ParallelParser::parseBodies(const std::vector<DeferredBody>& bodies, std::vector<BodyResult>& results) {
+    size_t worker_count = std::min<size_t>(threads, bodies.size());
+    if (worker_count == 0) return;
+
+    // Вначале у каждого потока - непрерывный отрезок тел
+    std::vector<WorkQueue> queues(worker_count);
+    for (size_t w = 0; w < worker_count; ++w) {
+        for (size_t i = bodies.size() * w / worker_count; i < bodies.size() * (w + 1) / worker_count; ++i) {
+            queues[w].tasks.push_back(i);
+        }
+    }
+
+    std::vector<size_t> steals(worker_count, 0);
+    // Локальные символы тел выделяет анализатор потока, а связаны они с
+    // деревом первого прохода, поэтому после разбора их память переходит к нему
+    std::vector<std::unique_ptr<Parser>> body_parsers(worker_count);
+    auto work = [&](size_t self) {
+        // Все имена уже в таблице атомов, поэтому потоки её только читают
+        body_parsers[self].reset(new Parser(tokens));
+        Parser& body_parser = *body_parsers[self];
+        body_parser.setLevel(PARSE_CHECK);
+        body_parser.getDiagnostics().deferWarnings(true);
+        size_t task;
+        while (takeTask(queues, self, task, steals[self])) {
+            BodyResult& result = results[task];
+            result.clean = body_parser.parseBody(bodies[task]);
+            result.diagnostics = body_parser.getDiagnostics();
+            result.assigned_globals = body_parser.getAnalyzer().getAssignedGlobals();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t w = 1; w < worker_count; ++w) workers.emplace_back(work, w);
+    work(0);
+    for (std::thread& worker : workers) worker.join();
+    for (std::unique_ptr<Parser>& body_parser : body_parsers) {
+        parser.getAnalyzer().adoptSymbols(body_parser->getAnalyzer());
+    }
+
+    for (size_t count : steals) stolen += count;
+}
+
+const DiagnosticSink& ParallelParser::getDiagnostics() const {
+    return sequential != nullptr ? sequential->getDiagnostics() : diagnostics;
+}
+
+const SourceMap& ParallelParser::getSourceMap() const {
+    return tokens->getSourceMap();
+}
+
+size_t ParallelParser::getBodyCount() const {
+    return body_count;
+}
+
+size_t ParallelParser::getStolenCount() const {
+    return stolen;
+}
+
+bool ParallelParser::usedFallback() const {
+    return sequential != nullptr;
+}
+
+void ParallelParser::printStats(std::ostream& out) const {
+    out << "Parallel: " << body_count << " function bodies on " << threads << " threads, "
+        << stolen << " stolen";
+    if (usedFallback()) out << ", reparsed sequentially";
+    out << std::endl;
+}
@@ -0,0 +1,60 @@
+#ifndef PARALLEL_PARSER_H
+#define PARALLEL_PARSER_H
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include "diagnostics.h"
+#include "parser.h"
+#include "token_buffer.h"
+
+// Двухпроходный разбор буфера лексем. Первый проход последовательно
+// разбирает описания и заголовки функций, а тела функций пропускает по
+// парным скобкам. Второй проход разбирает и проверяет тела одновременно в
+// нескольких потоках (у каждого потока своя очередь тел; опустевший поток
+// забирает тела из конца чужих очередей). Тело видит только глобальные
+// описания до своей функции и ничего в них не меняет.
+//
+// Сообщения собираются по телам и склеиваются в порядке текста, поэтому
+// результат не зависит от числа потоков и совпадает с обычным разбором:
+// предупреждения выводятся в конце разбора, о глобальной переменной -
+// с учётом присваиваний ей в предыдущих функциях. Если какое-то тело
+// разобрано не так, как разобрал бы его обычный разбор (ошибка сбила
+// парные скобки), весь буфер разбирается заново последовательно.
+// Синтаксическое дерево в этом режиме не строится целиком.
+class ParallelParser {
+public:
+    ParallelParser(TokenBuffer* tokens, unsigned threads);
+
+    // Как Parser::parse: предупреждения - в std::cout, семантическое дерево -
+    // если ошибок нет; ошибки - в getDiagnostics()
+    void parse();
+    const DiagnosticSink& getDiagnostics() const;
+    const SourceMap& getSourceMap() const;
+
+    size_t getBodyCount() const;
+    size_t getStolenCount() const;   // Тела, разобранные не своим потоком
+    bool usedFallback() const;       // Разбор был последовательным
+    void printStats(std::ostream& out) const;
+
+private:
+    // Результат разбора одного тела
+    struct BodyResult {
+        DiagnosticSink diagnostics;
+        std::unordered_set<Atom> assigned_globals;
+        bool clean = false;
+    };
+
+    TokenBuffer* tokens;
+    unsigned threads;
+    Parser parser;                       // Первый проход; владеет таблицей символов
+    std::unique_ptr<Parser> sequential;  // Запасной последовательный разбор
+    DiagnosticSink diagnostics;
+    size_t body_count;
+    size_t stolen;
+
+    void parseBodies(const std::vector<DeferredBody>& bodies, std::vector<BodyResult>& results);
+};
+
+#endif // PARALLEL_PARSER_H
@@ -1,19 +1,198 @@
 #include "parser.h"
+#include <array>
 #include <stdexcept>
+#include "type_rules.h"
+
+namespace {
+
+// Бинарная операция: сила связывания (0 - лексема не бинарная операция)
+// и ассоциативность. Новая операция - новая строка в makeBinaryOps.
+struct BinaryOp {
+    uint8_t power;
+    bool right_assoc;
+};
+
+const size_t TOKEN_TYPE_COUNT = T_ERROR + 1;
+
+constexpr std::array<BinaryOp, TOKEN_TYPE_COUNT> makeBinaryOps() {
+    std::array<BinaryOp, TOKEN_TYPE_COUNT> ops{};
+    ops[T_BIT_OR] = {1, false};
+    ops[T_BIT_XOR] = {2, false};
+    ops[T_BIT_AND] = {3, false};
+    ops[T_EQ] = {4, false};
+    ops[T_NE] = {4, false};
+    ops[T_LT] = {5, false};
+    ops[T_LE] = {5, false};
+    ops[T_GT] = {5, false};
+    ops[T_GE] = {5, false};
+    ops[T_LSHIFT] = {6, false};
+    ops[T_RSHIFT] = {6, false};
+    ops[T_PLUS] = {7, false};
+    ops[T_MINUS] = {7, false};
+    ops[T_MUL] = {8, false};
+    ops[T_DIV] = {8, false};
+    ops[T_MOD] = {8, false};
+    return ops;
+}
+
+constexpr std::array<BinaryOp, TOKEN_TYPE_COUNT> binary_ops = makeBinaryOps();
+
+// Начало оператора внутри функции
+bool startsStatement(TokenType type) {
+    return type == T_IDENT || type == T_MAIN || type == T_LBRACE || type == T_WHILE ||
+           type == T_SEMICOLON || type == T_INT || type == T_SHORT || // описания данных внутри функций
+           type == T_LONG || type == T_DOUBLE || type == T_CHAR;
+}
+
+// Начало описания: тип данных или void
+bool startsDeclaration(TokenType type) {
+    return type == T_SHORT || type == T_LONG || type == T_INT ||
+           type == T_DOUBLE || type == T_CHAR || type == T_VOID;
+}
+
+} // namespace
 
 // --- Конструктор и вспомогательные методы ---
 
-Parser::Parser(Scanner* scanner) : scanner(scanner) {
+Parser::Parser(Scanner* scanner)
+    : scanner(scanner), tokens(nullptr), queue(nullptr), token_index(0), source_map(&scanner->getSourceMap()),
+      current_token(), lookahead_head(0), lookahead_count(0), previous_type(T_EOF), panic_mode(false),
+      emitter(nullptr), level(PARSE_FULL), deferred_bodies(nullptr), bodies_unmatched(false) {
+    sem_analyzer.setSourceMap(source_map);
+    sem_analyzer.setDiagnostics(&diagnostics);
+    advance();
+}
+
+Parser::Parser(TokenBuffer* tokens)
+    : scanner(nullptr), tokens(tokens), queue(nullptr), token_index(0), source_map(&tokens->getSourceMap()),
+      current_token(), lookahead_head(0), lookahead_count(0), previous_type(T_EOF), panic_mode(false),
+      emitter(nullptr), level(PARSE_FULL), deferred_bodies(nullptr), bodies_unmatched(false) {
+    sem_analyzer.setSourceMap(source_map);
+    sem_analyzer.setDiagnostics(&diagnostics);
+    advance();
+}
+
+Parser::Parser(TokenQueue* queue)
+    : scanner(nullptr), tokens(nullptr), queue(queue), token_index(0), source_map(&queue->getSourceMap()),
+      current_token(), lookahead_head(0), lookahead_count(0), previous_type(T_EOF), panic_mode(false),
+      emitter(nullptr), level(PARSE_FULL), deferred_bodies(nullptr), bodies_unmatched(false) {
+    sem_analyzer.setSourceMap(source_map);
+    sem_analyzer.setDiagnostics(&diagnostics);
+    advance();
+}
+
+void Parser::parse(ParserEngine engine) {
+    ast.clear();
+    // Ошибка чтения входа (сбой ввода, повреждённый сжатый поток, лексема
+    // длиннее окна) прерывает разбор, но найденные до неё ошибки сохраняются
+    try {
+        if (engine == ENGINE_TABLE) {
+            parseTable();
+            return;
+        }
+        S();
+        consume(T_EOF, "Обнаружены лишние символы после конца программы.");
+    } catch (const std::runtime_error& e) {
+        diagnostics.error(e.what());
+    }
+}
+
+const Ast& Parser::getAst() const {
+    return ast;
+}
+
+const DiagnosticSink& Parser::getDiagnostics() const {
+    return diagnostics;
+}
+
+DiagnosticSink& Parser::getDiagnostics() {
+    return diagnostics;
+}
+
+const SourceMap& Parser::getSourceMap() const {
+    return *source_map;
+}
+
+SemanticAnalyzer& Parser::getAnalyzer() {
+    return sem_analyzer;
+}
+
+void Parser::setEmitter(CodeEmitter* code_emitter) {
+    emitter = code_emitter;
+    ast.setEnabled(emitter == nullptr && level == PARSE_FULL);
+}
+
+void Parser::setLevel(ParseLevel parse_level) {
+    level = parse_level;
+    ast.setEnabled(emitter == nullptr && level == PARSE_FULL);
+}
+
+// --- Разбор по описаниям (инкрементальный режим) ---
+
+void Parser::restart(Scanner* new_scanner) {
+    scanner = new_scanner;
+    tokens = nullptr;
+    queue = nullptr;
+    source_map = &scanner->getSourceMap();
+    sem_analyzer.setSourceMap(source_map);
+    lookahead_head = 0;
+    lookahead_count = 0;
+    panic_mode = false;
+    open_statements.clear();
+    expr_ops.clear();
+    expr_types.clear();
     advance();
 }
 
-void Parser::parse() {
-    S();
-    consume(T_EOF, "Обнаружены лишние символы после конца программы.");
+bool Parser::parseTopLevel() {
+    if (current_token.type == T_EOF) return false;
+    ast.clear();
+    try {
+        topLevelItem();
+    } catch (const std::runtime_error& e) {
+        diagnostics.error(e.what());
+        current_token.type = T_EOF; // Вход дальше не читается
+    }
+    return true;
+}
+
+SourceLoc Parser::currentLoc() const {
+    return current_token.loc;
 }
 
 void Parser::advance() {
-    current_token = scanner->getNextToken();
+    previous_type = current_token.type;
+    if (lookahead_count > 0) {
+        current_token = lookahead[lookahead_head];
+        lookahead_head = (lookahead_head + 1) % PARSER_LOOKAHEAD;
+        lookahead_count--;
+        return;
+    }
+    current_token = fetch();
+}
+
+Token Parser::fetch() {
+    if (tokens != nullptr) {
+        // T_EOF - последняя лексема буфера, дальше индекс не сдвигается
+        Token token = tokens->token(token_index);
+        if (token_index + 1 < tokens->size()) token_index++;
+        return token;
+    }
+    if (queue != nullptr) return queue->pop();
+    return scanner->getNextToken();
+}
+
+// Лексемы для просмотра вперёд читаются один раз и ждут в кольце,
+// поэтому каждый байт входа сканируется ровно однажды
+const Token& Parser::peek(size_t k) {
+    if (k == 0 || k > PARSER_LOOKAHEAD) {
+        throw std::logic_error("Глубина просмотра вперёд вне диапазона: " + std::to_string(k));
+    }
+    while (lookahead_count < k) {
+        lookahead[(lookahead_head + lookahead_count) % PARSER_LOOKAHEAD] = fetch();
+        lookahead_count++;
+    }
+    return lookahead[(lookahead_head + k - 1) % PARSER_LOOKAHEAD];
 }
 
 void Parser::consume(TokenType expected, const std::string& error_message) {
@@ -24,11 +203,40 @@ void Parser::consume(TokenType expected, const std::string& error_message) {
     }
 }
 
+// Ошибки, найденные в режиме паники, - обычно следствия первой, поэтому
+// о них не сообщается
 void Parser::error(const std::string& message) {
-    std::string error_message = message + 
-                                "\n\tНа строке " + std::to_string(current_token.line) + 
-                                ", получен токен: \"" + current_token.text + "\"";
-    throw std::runtime_error(error_message);
+    semanticError(message);
+    panic_mode = true;
+}
+
+void Parser::semanticError(const std::string& message) {
+    semanticError(message, current_token);
+}
+
+void Parser::semanticError(const std::string& message, const Token& at) {
+    if (panic_mode) return;
+    diagnostics.error(at.loc, message + "\n\tНа ", ", получен токен: \"" + std::string(at.text) + "\"");
+}
+
+// Восстановление в режиме паники. Внутри функции оператор заканчивается
+// после ';' или перед '}', новое описание начинается с типа данных. На
+// верхнем уровне синхронизация только по типу данных вне фигурных скобок:
+// тело функции, в заголовке которой ошибка, пропускается целиком.
+void Parser::synchronize(bool top_level) {
+    panic_mode = false;
+    if (!top_level && (previous_type == T_SEMICOLON || previous_type == T_RBRACE)) {
+        return; // Ошибочный оператор уже закончился
+    }
+    size_t depth = 0;
+    while (current_token.type != T_EOF) {
+        TokenType type = current_token.type;
+        if (depth == 0 && (startsDeclaration(type) || (!top_level && type == T_RBRACE))) return;
+        if (type == T_LBRACE) depth++;
+        if (type == T_RBRACE && depth > 0) depth--;
+        advance();
+        if (!top_level && type == T_SEMICOLON && depth == 0) return;
+    }
 }
 
 // --- Реализация функций-нетерминалов ---
@@ -36,22 +244,43 @@ void Parser::error(const std::string& message) {
 // S -> T
 void Parser::S() {
     T();
+    finishProgram();
+}
+
+// Конец программы: вывод таблицы символов или вызов main в байт-коде
+void Parser::finishProgram() {
+    if (emitter != nullptr) {
+        emitter->finishProgram(sem_analyzer.findSymbol(atom_table.intern("main")));
+        return;
+    }
     // Вывод построенного дерева для отладки и отчета
-    sem_analyzer.printTree(); 
+    if (level == PARSE_FULL && !diagnostics.hasErrors()) sem_analyzer.printTree();
 }
 
 // T -> T W | ε
+// Лексемы, с которых не может начаться описание, - ошибка; разбор
+// продолжается со следующего описания
 void Parser::T() {
-    while (current_token.type == T_SHORT || current_token.type == T_LONG ||
-           current_token.type == T_INT   || current_token.type == T_DOUBLE ||
-           current_token.type == T_CHAR  || current_token.type == T_VOID)
-    {
-        W();
+    SourceLoc loc = current_token.loc;
+    size_t mark = ast.mark();
+    while (current_token.type != T_EOF) {
+        topLevelItem();
     }
+    ast.node(N_PROGRAM, TYPE_UNDEFINED, loc, ast.mark() - mark);
+}
 
-    if (current_token.type == T_IDENT) {
+// Одно описание верхнего уровня или ошибочные лексемы до следующего описания.
+// После него режим паники снят, поэтому разбор следующего описания не
+// зависит ни от чего, кроме текста с его начала.
+void Parser::topLevelItem() {
+    if (startsDeclaration(current_token.type)) {
+        W();
+    } else if (current_token.type == T_IDENT) {
         error("Недопустимый идентификатор в глобальной области. Возможно, пропущен тип данных или описание функции.");
+    } else {
+        error("Обнаружены лишние символы после конца программы.");
     }
+    if (panic_mode) synchronize(true);
 }
 
 // W -> D | F
@@ -67,14 +296,18 @@ void Parser::W() {
     }
     else {
         error("Ожидалось описание данных или функции.");
+        ast.leaf(N_ERROR, TYPE_UNDEFINED, current_token.loc);
     }
 }
 
 // D -> Tp Z ;
 void Parser::D() {
+    SourceLoc loc = current_token.loc;
+    size_t mark = ast.mark();
     DataType type = Tp();
     Z(type);
     consume(T_SEMICOLON, "Ожидалась ';' после описания переменных.");
+    ast.node(N_DATA, type, loc, ast.mark() - mark);
 }
 
 // Tp -> t1 | t2 | t3 | t4 | ...
@@ -98,78 +331,134 @@ void Parser::Z(DataType type) {
         Token id_token = current_token;
         if (id_token.type != T_IDENT && id_token.type != T_MAIN) {
             error("Ожидался идентификатор переменной.");
+            return;
         }
         
-        Symbol* new_var = new Symbol{id_token.text, CAT_VARIABLE, type};
-        new_var->var_info.is_initialized = false;
-
-        if (!sem_analyzer.addSymbol(new_var)) {
-            error("Повторное объявление переменной '" + id_token.text + "'");
-        }
-
+        bool added;
+        Symbol* new_var = declareVariable(id_token, type, added);
         advance();
 
+        size_t init_count = 0;
         if (current_token.type == T_ASSIGN) {
             advance();
             DataType expr_type = V();
-
-            sem_analyzer.semCheckAssignment(new_var, expr_type, id_token.line);
-            new_var->var_info.is_initialized = true;
+            init_count = 1;
+            initializeVariable(new_var, expr_type, id_token);
         }
+        finishVariable(new_var, added, id_token, type, init_count);
     } while (current_token.type == T_COMMA ? (advance(), true) : false);
 }
 
 // F -> void a (G) Q
 void Parser::F() {
+    SourceLoc loc = current_token.loc;
     consume(T_VOID, "Ожидалось ключевое слово 'void' в описании функции.");
     
     Token func_id = current_token;
+    // Имя нужно и после разбора параметров, когда текст лексемы может быть уже
+    // недействителен (в потоковом режиме сканер хранит текст лишь последних лексем),
+    // поэтому запоминается атом
+    Atom func_name = func_id.atom;
     if (func_id.type == T_IDENT || func_id.type == T_MAIN) {
         advance();
     } else {
         error("Ожидалось имя функции (идентификатор или 'main').");
     }
 
+    size_t mark = ast.mark();
     consume(T_LPAREN, "Ожидалась '(' после имени функции.");
-    std::vector<Param*> params = G();
+    std::vector<Param> params = G();
     consume(T_RPAREN, "Ожидалась ')' после списка параметров.");
 
-    // Объявляем функцию
-    Symbol* new_func = new Symbol{func_id.text, CAT_FUNCTION, TYPE_VOID};
-    new_func->func_info.param_count = params.size();
-    
-    for (size_t i = 0; i < params.size(); ++i) {
-        if (i + 1 < params.size()) params[i]->next = params[i+1];
+    // Заголовок не разобран: функция не объявляется, тело пропустит синхронизация
+    if (panic_mode) {
+        ast.node(N_ERROR, TYPE_UNDEFINED, loc, ast.mark() - mark);
+        return;
     }
-    new_func->func_info.params = params.empty() ? nullptr : params[0];
 
-    if (!sem_analyzer.addSymbol(new_func)) {
-        error("Повторное объявление функции '" + func_id.text + "'");
-    }
-    
-    sem_analyzer.enterScope(); // Входим в область видимости функции
+    bool added;
+    Symbol* new_func = declareFunction(func_name, params, added);
 
-    // Объявляем параметры в новой области
-    for(Param* p : params) {
-        Symbol* param_sym = new Symbol{p->name, CAT_PARAMETER, p->type};
-        param_sym->var_info.is_initialized = true;
-        if (!sem_analyzer.addSymbol(param_sym)) {
-            error("Повторное объявление параметра '" + p->name + "'");
-        }
+    // Q(); // Разбираем тело функции
+
+    if (deferred_bodies != nullptr && current_token.type == T_LBRACE) {
+        deferBody();
+    } else {
+        functionBody();
     }
 
-    // Q(); // Разбираем тело функции
+    finishFunction(new_func, added);
+    ast.node(N_FUNCTION, TYPE_VOID, func_id.loc, params.size() + 1, func_name); // Параметры и тело
+}
 
+void Parser::functionBody() {
+    SourceLoc body_loc = current_token.loc;
     consume(T_LBRACE, "Ожидался символ '{' для начала тела функции.");
-    K(); // Разбираем список операторов
+    size_t body_mark = ast.mark();
+    if (!panic_mode) K(); // Разбираем список операторов
+    ast.node(N_BLOCK, TYPE_UNDEFINED, body_loc, ast.mark() - body_mark);
     consume(T_RBRACE, "Ожидался символ '}' для завершения тела функции.");
-    
-    sem_analyzer.leaveScope(); // Выходим из области видимости функции
+}
+
+// Пропуск тела по парным скобкам; в дереве вместо тела - пустой блок
+void Parser::deferBody() {
+    size_t open = token_index - 1 - lookahead_count; // Индекс текущей лексемы '{'
+    size_t close = open;
+    size_t depth = 0;
+    for (;; ++close) {
+        TokenType type = tokens->type(close);
+        if (type == T_LBRACE) {
+            depth++;
+        } else if (type == T_RBRACE) {
+            if (--depth == 0) break;
+        } else if (type == T_IDENT || type == T_MAIN) {
+            atom_table.intern(tokens->text(close));
+        } else if (type == T_EOF) {
+            bodies_unmatched = true;
+            functionBody();
+            return;
+        }
+    }
+
+    deferred_bodies->push_back({open, close, sem_analyzer.getCurrentScope(), &sem_analyzer, std::move(diagnostics)});
+    diagnostics.clear();
+    ast.node(N_BLOCK, TYPE_UNDEFINED, current_token.loc, 0);
+
+    token_index = close;
+    lookahead_count = 0;
+    advance(); // '}'
+    advance();
+}
+
+void Parser::deferBodies(std::vector<DeferredBody>* bodies) {
+    deferred_bodies = bodies;
+    if (bodies != nullptr) bodies_unmatched = false;
+}
+
+bool Parser::allBodiesDeferred() const {
+    return !bodies_unmatched;
+}
+
+bool Parser::parseBody(const DeferredBody& body) {
+    token_index = body.open_index;
+    lookahead_count = 0;
+    panic_mode = false;
+    open_statements.clear();
+    expr_ops.clear();
+    expr_types.clear();
+    ast.clear();
+    diagnostics.clear();
+    advance();
+
+    sem_analyzer.enterBody(body.analyzer, body.scope);
+    functionBody();
+    sem_analyzer.leaveScope();
+    return !panic_mode && current_token.loc == tokens->offset(body.close_index + 1);
 }
 
 // G -> Zf | ε
-std::vector<Param*> Parser::G() {
-    std::vector<Param*> params;
+std::vector<Param> Parser::G() {
+    std::vector<Param> params;
     if (current_token.type == T_SHORT || current_token.type == T_LONG ||
         current_token.type == T_INT   || current_token.type == T_DOUBLE ||
         current_token.type == T_CHAR) 
@@ -180,7 +469,7 @@ std::vector<Param*> Parser::G() {
 }
 
 // Zf -> Ps | Zf, Ps
-void Parser::Zf(std::vector<Param*>& params) {
+void Parser::Zf(std::vector<Param>& params) {
     do {
         params.push_back(Ps());
     } while (current_token.type == T_COMMA ? (advance(), true) : false);
@@ -194,32 +483,24 @@ void Parser::Zf(std::vector<Param*>& params) {
 }
 
 // Ps -> Tp a
-Param* Parser::Ps() {
+Param Parser::Ps() {
     DataType type = Tp();
     Token id_token = current_token;
     consume(T_IDENT, "Ожидался идентификатор параметра.");
     
-    Param* new_param = new Param{id_token.text, type};
-    return new_param;
+    ast.leaf(N_PARAM, type, id_token.loc, id_token.atom);
+    return Param{id_token.atom, type};
 }
 
 // O -> P; | Q | U | H; | D | ;
+// Q и U только открывают конструкцию (см. K)
 void Parser::O() {
     switch (current_token.type) {
         case T_IDENT:
         case T_MAIN:
         {
             // Lookahead на 1 токен, чтобы отличить вызов функции (H) от присваивания (P)
-            size_t old_pos = scanner->getUK();
-            int old_line = scanner->getLine();
-            Token ident_token = current_token;
-            
-            advance();
-            TokenType next_type = current_token.type;
-            
-            scanner->putUK(old_pos);
-            scanner->setLine(old_line);
-            current_token = ident_token;
+            TokenType next_type = peek(1).type;
 
             if (next_type == T_LPAREN) {
                 H();
@@ -248,34 +529,62 @@ void Parser::O() {
             break;
 
         case T_SEMICOLON:
+            ast.leaf(N_EMPTY, TYPE_UNDEFINED, current_token.loc);
             advance();
             break;
 
         default:
             error("Ожидался оператор или описание данных.");
+            ast.leaf(N_ERROR, TYPE_UNDEFINED, current_token.loc);
             break;
     }
 }
 
 // Q -> {K}
+// Открывает блок; закрывает его K, дойдя до конца списка операторов
 void Parser::Q() {
+    SourceLoc loc = current_token.loc;
     consume(T_LBRACE, "Ожидался символ '{' для начала составного оператора.");
-    sem_analyzer.enterScope();
-    K();
-    sem_analyzer.leaveScope();
-    consume(T_RBRACE, "Ожидался символ '}' для завершения составного оператора.");
+    openScope();
+    if (emitter != nullptr) emitter->openBlock();
+    open_statements.push_back({N_BLOCK, loc, ast.mark(), 0, 0});
 }
 
 // K -> K O | ε
+// Вложенные блоки (Q) и тела циклов (U) разбираются без рекурсии: открытые
+// конструкции лежат на явном стеке open_statements, поэтому глубина
+// вложенности ограничена памятью, а не стеком потока. Порядок действий -
+// проверок, сообщений и узлов дерева - тот же, что у рекурсивного спуска.
 void Parser::K() {
-    while (current_token.type == T_IDENT || current_token.type == T_MAIN ||
-           current_token.type == T_LBRACE || current_token.type == T_WHILE ||
-           current_token.type == T_SEMICOLON || 
-           current_token.type == T_INT || current_token.type == T_SHORT || // описания данных внутри функций
-           current_token.type == T_LONG || current_token.type == T_DOUBLE ||
-           current_token.type == T_CHAR)
-    {
-        O();
+    size_t base = open_statements.size();
+    while (true) {
+        if (startsStatement(current_token.type)) {
+            size_t depth = open_statements.size();
+            O();
+            if (open_statements.size() > depth) continue; // Открыт блок или цикл
+        } else if (open_statements.size() > base && open_statements.back().kind == N_WHILE) {
+            error("Ожидался оператор или описание данных."); // Тело цикла обязательно
+            ast.leaf(N_ERROR, TYPE_UNDEFINED, current_token.loc);
+        } else if (open_statements.size() > base) {
+            // Конец операторов вложенного блока
+            OpenStatement block = open_statements.back();
+            open_statements.pop_back();
+            ast.node(N_BLOCK, TYPE_UNDEFINED, block.loc, ast.mark() - block.mark);
+            closeScope();
+            if (emitter != nullptr) emitter->closeBlock();
+            consume(T_RBRACE, "Ожидался символ '}' для завершения составного оператора.");
+        } else {
+            return;
+        }
+
+        // Оператор закончен; он может быть телом циклов, которые тоже закончены
+        while (open_statements.size() > base && open_statements.back().kind == N_WHILE) {
+            const OpenStatement& loop = open_statements.back();
+            if (emitter != nullptr) emitter->loopEnd(loop.loop_start, loop.loop_exit);
+            ast.node(N_WHILE, TYPE_UNDEFINED, loop.loc, 2);
+            open_statements.pop_back();
+        }
+        if (panic_mode) synchronize(false);
     }
 }
 
@@ -288,29 +597,24 @@ void Parser::P() {
         error("Ожидался идентификатор (переменная) слева от '='.");
     }
 
-    Symbol* var_sym = sem_analyzer.findSymbol(id_token.text);
-    if (var_sym == nullptr) {
-        error("Использование необъявленной переменной '" + id_token.text + "'");
-    }
-    
+    Symbol* var_sym = assignTarget(id_token);
     consume(T_ASSIGN, "Ожидался оператор присваивания '='.");
     DataType right_type = V();
-    
-    sem_analyzer.semCheckAssignment(var_sym, right_type, id_token.line);
-    var_sym->var_info.is_initialized = true; 
+    DataType type = finishAssignment(var_sym, right_type, id_token);
+    ast.node(N_ASSIGN, type, id_token.loc, 1, id_token.atom);
 }
 
 // U -> while (V) O
+// Открывает цикл; телом станет следующий оператор, разобранный K
 void Parser::U() {
+    SourceLoc loc = current_token.loc;
     consume(T_WHILE, "Ожидался 'while'.");
     consume(T_LPAREN, "Ожидалась '(' после 'while'.");
+    uint32_t start = emitter != nullptr ? emitter->here() : 0;
     DataType cond_type = V(); // Получаем тип условия
-    // Проверяем тип условия ---
-    if (cond_type == TYPE_VOID) {
-        error("Выражение в условии 'while' не может быть типа void.");
-    }
+    uint32_t exit = checkCondition(cond_type);
     consume(T_RPAREN, "Ожидалась ')' после условия в 'while'.");
-    O();
+    open_statements.push_back({N_WHILE, loc, 0, start, exit});
 }
 
 // H -> a(L)
@@ -320,29 +624,22 @@ void Parser::H() {
         error("Ожидалось имя функции для вызова.");
     }
 
-    // Проверяем идентификатор функции
-    Symbol* func_sym = sem_analyzer.findSymbol(id_token.text);
-    if (func_sym == nullptr) {
-        error("Вызов необъявленной функции '" + id_token.text + "'");
-    }
-    if (func_sym->category != CAT_FUNCTION) {
-        error("'" + id_token.text + "' не является функцией.");
-    }
-
+    Symbol* func_sym = callTarget(id_token);
     advance(); 
 
     consume(T_LPAREN, "Ожидалась '(' при вызове функции.");
+    size_t mark = ast.mark();
     L(func_sym); // Передаем информацию о функции для проверки параметров
     consume(T_RPAREN, "Ожидалась ')' после списка параметров функции.");
+    if (emitter != nullptr && func_sym != nullptr) emitter->call(func_sym);
+    ast.node(N_CALL, TYPE_VOID, id_token.loc, ast.mark() - mark, id_token.atom);
 }
 
 // L -> M | ε
 void Parser::L(Symbol* func_sym) {
     // Проверяем, есть ли параметры, если они не требуются
     if (current_token.type == T_RPAREN) {
-        if (func_sym->func_info.param_count != 0) {
-            error("Неверное количество аргументов при вызове функции '" + func_sym->name + "'");
-        }
+        checkNoArguments(func_sym);
         return; // Пустой список параметров
     }
     
@@ -351,210 +648,339 @@ void Parser::L(Symbol* func_sym) {
 }
 
 // M -> V | M, V
+// func_sym == nullptr - функция неизвестна, аргументы только разбираются
 void Parser::M(Symbol* func_sym) {
-    int arg_count = 0;
-    Param* current_param = func_sym->func_info.params;
-
+    CallArgs args = {func_sym, func_sym != nullptr ? func_sym->func_info.params : nullptr, 0, false};
     do {
-        arg_count++;
-        DataType arg_type = V();
-        // Проверяем тип параметра
-        if (current_param == nullptr) {
-            error("Слишком много аргументов при вызове функции '" + func_sym->name + "'");
-        }
-        if (arg_type != current_param->type) { // Упрощенная проверка
-            error("Несоответствие типа для аргумента " + std::to_string(arg_count) + " при вызове функции '" + func_sym->name + "'");
-        }
-        current_param = current_param->next;
+        checkArgument(args, V());
     } while (current_token.type == T_COMMA ? (advance(), true) : false);
-
-    if (arg_count != func_sym->func_info.param_count) {
-        error("Неверное количество аргументов при вызове функции '" + func_sym->name + "'");
-    }
+    finishArguments(args);
 }
 
 // --- Функции для разбора выражений ---
 
-// V -> V '|' Vx | Vx
+// V -> Vu { op Vu }, Vu -> '+' E | '-' E | E, E -> a | C | (V)
+// Выражение разбирается без рекурсии, сортировочной станцией: операции и
+// открытые скобки ждут на стеке expr_ops, типы готовых операндов - на
+// expr_types. Бинарная операция сворачивается, когда приходит операция не
+// сильнее её (при правой ассоциативности - слабее), поэтому порядок вызовов
+// semCheckBinaryExpr и узлов дерева тот же, что у подъёма по приоритетам:
+// левый операнд - раньше, более сильная операция справа - раньше своей
+// левой соседки. Глубина скобок ограничена только памятью.
 DataType Parser::V() {
-    DataType left_type = Vx();
-    while (current_token.type == T_BIT_OR) {
-        Token op = current_token;
-        advance();
-        DataType right_type = Vx();
-        
-        left_type = sem_analyzer.semCheckBinaryExpr(left_type, op, right_type, op.line);
+    size_t op_base = expr_ops.size();
+    while (true) {
+        // Операнд: необязательный унарный знак, затем '(' или элементарное выражение
+        if (current_token.type == T_PLUS || current_token.type == T_MINUS) {
+            expr_ops.push_back({current_token, 0, true});
+            advance();
+        }
+        if (current_token.type == T_LPAREN) {
+            expr_ops.push_back({current_token, 0, false});
+            advance();
+            continue;
+        }
+        expr_types.push_back(E());
+
+        // Операнд готов: за ним бинарная операция, ')' или конец выражения
+        while (true) {
+            if (expr_ops.size() > op_base && expr_ops.back().unary) reduceUnary();
+
+            BinaryOp info = binary_ops[current_token.type];
+            if (info.power != 0) {
+                while (expr_ops.size() > op_base && expr_ops.back().power != 0 &&
+                       (expr_ops.back().power > info.power ||
+                        (expr_ops.back().power == info.power && !info.right_assoc))) {
+                    reduceBinary();
+                }
+                expr_ops.push_back({current_token, info.power, false});
+                advance();
+                break; // К правому операнду
+            }
+
+            while (expr_ops.size() > op_base && expr_ops.back().power != 0) reduceBinary();
+            if (expr_ops.size() == op_base) {
+                DataType type = expr_types.back();
+                expr_types.pop_back();
+                return type;
+            }
+            // На вершине - '(': выражение в скобках стало операндом
+            expr_ops.pop_back();
+            consume(T_RPAREN, "Ожидалась ')' для закрытия выражения в скобках.");
+        }
     }
-    return left_type;
 }
 
-// Vx -> Vx '^' Va | Va
-DataType Parser::Vx() {
-    DataType left_type = Va();
-    while (current_token.type == T_BIT_XOR) {
-        Token op = current_token;
-        advance();
-        DataType right_type = Va();
-        left_type = sem_analyzer.semCheckBinaryExpr(left_type, op, right_type, op.line);
-    }
-    return left_type;
+// Свёртка бинарной операции с вершины expr_ops над двумя верхними операндами
+void Parser::reduceBinary() {
+    Token op = expr_ops.back().op;
+    expr_ops.pop_back();
+    DataType right_type = expr_types.back();
+    expr_types.pop_back();
+    DataType left_type = expr_types.back();
+    DataType type = level == PARSE_SYNTAX ? TYPE_UNDEFINED
+                                          : sem_analyzer.semCheckBinaryExpr(left_type, op, right_type, op.loc);
+    if (emitter != nullptr) emitter->binary(op.type, left_type, right_type);
+    expr_types.back() = type;
+    ast.node(N_BINARY, type, op.loc, 2, 0, static_cast<uint8_t>(op.type));
 }
 
-// Va -> Va '&' Ve | Ve
-DataType Parser::Va() {
-    DataType left_type = Ve();
-    while (current_token.type == T_BIT_AND) {
-        Token op = current_token;
-        advance();
-        DataType right_type = Ve();
-        left_type = sem_analyzer.semCheckBinaryExpr(left_type, op, right_type, op.line);
+// Свёртка унарного знака над только что разобранным операндом
+void Parser::reduceUnary() {
+    Token op = expr_ops.back().op;
+    expr_ops.pop_back();
+    DataType type = expr_types.back();
+    // Проверка для унарных операций
+    if (type != TYPE_INT && type != TYPE_SHORT && type != TYPE_LONG && type != TYPE_DOUBLE && type != TYPE_CHAR &&
+        type != TYPE_UNDEFINED) {
+        semanticError("Унарный оператор '" + std::string(op.text) + "' применим только к числовым типам.");
     }
-    return left_type;
+    if (emitter != nullptr) emitter->unary(op.type, type);
+    ast.node(N_UNARY, type, op.loc, 1, 0, static_cast<uint8_t>(op.type));
 }
 
-// Ve -> Ve '==' Vr | Ve '!=' Vr | Vr
-DataType Parser::Ve() {
-    DataType left_type = Vr();
-    while (current_token.type == T_EQ || current_token.type == T_NE) {
-        Token op = current_token;
-        advance();
-        DataType right_type = Vr();
-        left_type = sem_analyzer.semCheckBinaryExpr(left_type, op, right_type, op.line);
+// E -> a | C   (выражение в скобках разбирает V)
+DataType Parser::E() {
+    switch (current_token.type) {
+        case T_IDENT:
+        case T_MAIN: {
+            DataType type = nameOperand(current_token);
+            advance();
+            return type;
+        }
+
+        case T_DEC_CONST:
+        case T_HEX_CONST:
+        case T_FLOAT_CONST:
+        case T_CHAR_CONST:
+            return C();
+            
+        default:
+            error("Ожидался операнд (переменная, константа или выражение в скобках).");
+            ast.leaf(N_ERROR, TYPE_UNDEFINED, current_token.loc);
+            return TYPE_UNDEFINED;
     }
-    return left_type;
 }
 
-// Vr -> Vr '<' Vs | ... | Vs
-DataType Parser::Vr() {
-    DataType left_type = Vs();
-    while (current_token.type == T_LT || current_token.type == T_LE ||
-           current_token.type == T_GT || current_token.type == T_GE) 
-    {
-        Token op = current_token;
-        advance();
-        DataType right_type = Vs();
-        left_type = sem_analyzer.semCheckBinaryExpr(left_type, op, right_type, op.line);
+// C -> c1 | c2 | c3 | c4
+DataType Parser::C() {
+    switch(current_token.type) {
+        case T_DEC_CONST:
+        case T_HEX_CONST:
+        case T_FLOAT_CONST:
+        case T_CHAR_CONST: {
+            DataType type = constantOperand(current_token);
+            advance();
+            return type;
+        }
+        default:
+            error("Ожидалась константа.");
+            ast.leaf(N_ERROR, TYPE_UNDEFINED, current_token.loc);
+            return TYPE_UNDEFINED;
     }
-    return left_type;
 }
 
-// Vs -> Vs '<<' A | Vs '>>' A | A
-DataType Parser::Vs() {
-    DataType left_type = A();
-    while (current_token.type == T_LSHIFT || current_token.type == T_RSHIFT) {
-        Token op = current_token;
-        advance();
-        DataType right_type = A();
-        left_type = sem_analyzer.semCheckBinaryExpr(left_type, op, right_type, op.line);
+// --- Семантические действия ---
+// Общие для рекурсивного спуска и табличного разбора (parser_table.cpp):
+// оба вызывают их, стоя на тех же лексемах, поэтому проверки, сообщения и
+// узлы дерева у них одинаковые. При PARSE_SYNTAX действия не трогают
+// анализатор: символов нет (nullptr), типы имён - TYPE_UNDEFINED.
+
+// Повторно объявленная переменная в таблицу не попадает, но её
+// инициализатор всё равно разбирается и проверяется
+Symbol* Parser::declareVariable(const Token& id_token, DataType type, bool& added) {
+    if (level == PARSE_SYNTAX) {
+        added = false;
+        return nullptr;
+    }
+    Symbol* new_var = sem_analyzer.newSymbol(id_token.atom, CAT_VARIABLE, type);
+    new_var->var_info.is_initialized = false;
+    added = sem_analyzer.addSymbol(new_var);
+    if (!added) {
+        semanticError("Повторное объявление переменной '" + std::string(id_token.text) + "'", id_token);
     }
-    return left_type;
+    if (emitter != nullptr) emitter->declareVariable(new_var, added);
+    return new_var;
 }
 
-// A -> A '+' B | A '-' B | B
-DataType Parser::A() {
-    DataType left_type = B();
-    while (current_token.type == T_PLUS || current_token.type == T_MINUS) {
-        Token op = current_token;
-        advance();
-        DataType right_type = B();
-        left_type = sem_analyzer.semCheckBinaryExpr(left_type, op, right_type, op.line);
-    }
-    return left_type;
+void Parser::initializeVariable(Symbol* var, DataType expr_type, const Token& id_token) {
+    if (level == PARSE_SYNTAX) return;
+    sem_analyzer.semCheckAssignment(var, expr_type, id_token.loc);
+    if (emitter != nullptr) emitter->store(var, expr_type);
+    var->var_info.is_initialized = true;
 }
 
-// B -> B '*' Vu | ... | Vu
-DataType Parser::B() {
-    DataType left_type = Vu();
-    while (current_token.type == T_MUL || current_token.type == T_DIV || current_token.type == T_MOD) {
-        Token op = current_token;
-        advance();
-        DataType right_type = Vu();
-        left_type = sem_analyzer.semCheckBinaryExpr(left_type, op, right_type, op.line);
-    }
-    return left_type;
+void Parser::finishVariable(Symbol* var, bool added, const Token& id_token, DataType type, size_t init_count) {
+    if (emitter != nullptr && init_count == 0) emitter->clearVariable(var);
+    if (!added) sem_analyzer.freeSymbol(var);
+    ast.node(N_VAR, type, id_token.loc, init_count, id_token.atom);
 }
 
-// Vu -> '+' E | '-' E | E
-DataType Parser::Vu() {
-    if (current_token.type == T_PLUS || current_token.type == T_MINUS) {
-        Token op = current_token;
-        advance();
-        DataType type = E();
-        // Проверка для унарных операций
-        if (type != TYPE_INT && type != TYPE_SHORT && type != TYPE_LONG && type != TYPE_DOUBLE && type != TYPE_CHAR) {
-            error("Унарный оператор '" + op.text + "' применим только к числовым типам.");
+// Объявляет функцию и входит в её область с параметрами. Параметры
+// копируются в арену анализатора срезом. Тело повторно объявленной функции всё равно
+// разбирается и проверяется.
+Symbol* Parser::declareFunction(Atom name, const std::vector<Param>& params, bool& added) {
+    if (level == PARSE_SYNTAX) {
+        added = false;
+        return nullptr;
+    }
+    Symbol* new_func = sem_analyzer.newSymbol(name, CAT_FUNCTION, TYPE_VOID);
+    new_func->func_info.param_count = params.size();
+    new_func->func_info.params = sem_analyzer.newParams(params);
+
+    added = sem_analyzer.addSymbol(new_func);
+    if (!added) {
+        semanticError("Повторное объявление функции '" + SemanticAnalyzer::symbolName(name) + "'");
+    }
+    
+    sem_analyzer.enterScope(); // Входим в область видимости функции
+    if (emitter != nullptr) emitter->beginFunction(new_func);
+
+    // Объявляем параметры в новой области
+    for (const Param& p : params) {
+        Symbol* param_sym = sem_analyzer.newSymbol(p.name, CAT_PARAMETER, p.type);
+        param_sym->var_info.is_initialized = true;
+        if (emitter != nullptr) emitter->declareParameter(param_sym);
+        if (!sem_analyzer.addSymbol(param_sym)) {
+            semanticError("Повторное объявление параметра '" + SemanticAnalyzer::symbolName(p.name) + "'");
+            sem_analyzer.freeSymbol(param_sym);
         }
-        return type;
-    } else {
-        return E();
     }
+    return new_func;
 }
 
-// E -> a | C | (V)
-DataType Parser::E() {
-    switch (current_token.type) {
-        case T_IDENT:
-        case T_MAIN: {
-            Token id_token = current_token;
-            Symbol* sym = sem_analyzer.findSymbol(id_token.text);
-            if (sym == nullptr) {
-                error("Использование необъявленного идентификатора '" + id_token.text + "'");
-            }
+void Parser::finishFunction(Symbol* func, bool added) {
+    if (level == PARSE_SYNTAX) return;
+    if (emitter != nullptr) emitter->endFunction();
+    sem_analyzer.leaveScope(); // Выходим из области видимости функции
+    if (!added) sem_analyzer.freeSymbol(func);
+}
 
-            if (sym->category == CAT_FUNCTION) {
-                error("Имя функции '" + id_token.text + "' не может быть использовано в выражении.");
-            }
+// Левая часть присваивания; nullptr - имя не объявлено
+Symbol* Parser::assignTarget(const Token& id_token) {
+    if (level == PARSE_SYNTAX) return nullptr;
+    Symbol* var_sym = sem_analyzer.findSymbol(id_token.atom);
+    if (var_sym == nullptr) {
+        semanticError("Использование необъявленной переменной '" + std::string(id_token.text) + "'");
+    }
+    return var_sym;
+}
 
-            // Проверка на инициализацию
-            if (sym->category == CAT_VARIABLE || sym->category == CAT_PARAMETER) {
-                if (!sym->var_info.is_initialized) {
-                    std::cout << "Warning: На строке " << id_token.line
-                              << ": переменная '" << id_token.text 
-                              << "' используется неинициализированной." << std::endl;
-                }
-            }
+DataType Parser::finishAssignment(Symbol* var_sym, DataType right_type, const Token& id_token) {
+    if (var_sym == nullptr) return TYPE_UNDEFINED;
+    sem_analyzer.semCheckAssignment(var_sym, right_type, id_token.loc);
+    if (var_sym->category != CAT_FUNCTION) {
+        if (emitter != nullptr) emitter->store(var_sym, right_type);
+        sem_analyzer.markInitialized(var_sym);
+    }
+    return var_sym->type;
+}
 
-            advance();
+// Возвращает адрес перехода из цикла (0 без генерации кода)
+uint32_t Parser::checkCondition(DataType cond_type) {
+    if (cond_type == TYPE_VOID) {
+        semanticError("Выражение в условии 'while' не может быть типа void.");
+    }
+    return emitter != nullptr ? emitter->jumpIfFalse(cond_type) : 0;
+}
+
+// Проверяем идентификатор функции; аргументы вызова неизвестной функции
+// (nullptr) разбираются без сверки с параметрами
+Symbol* Parser::callTarget(const Token& id_token) {
+    if (level == PARSE_SYNTAX) return nullptr;
+    Symbol* func_sym = sem_analyzer.findSymbol(id_token.atom);
+    if (func_sym == nullptr) {
+        semanticError("Вызов необъявленной функции '" + std::string(id_token.text) + "'", id_token);
+    } else if (func_sym->category != CAT_FUNCTION) {
+        semanticError("'" + std::string(id_token.text) + "' не является функцией.", id_token);
+        func_sym = nullptr;
+    }
+    return func_sym;
+}
 
-            return sym->type;
+void Parser::checkNoArguments(Symbol* func_sym) {
+    if (func_sym != nullptr && func_sym->func_info.param_count != 0) {
+        semanticError("Неверное количество аргументов при вызове функции '" + SemanticAnalyzer::symbolName(func_sym->name) + "'");
+    }
+}
+
+void Parser::checkArgument(CallArgs& args, DataType arg_type) {
+    args.count++;
+    if (args.func == nullptr) return;
+    // Проверяем тип параметра
+    if (args.param == nullptr) {
+        if (!args.count_reported) {
+            semanticError("Слишком много аргументов при вызове функции '" + SemanticAnalyzer::symbolName(args.func->name) + "'");
+            args.count_reported = true;
         }
+        return;
+    }
+    if (conversions[SITE_ARGUMENT][args.param->type][arg_type] != CONV_OK) {
+        semanticError("Несоответствие типа для аргумента " + std::to_string(args.count) + " при вызове функции '" + SemanticAnalyzer::symbolName(args.func->name) + "'");
+    }
+    if (emitter != nullptr) emitter->convert(arg_type, args.param->type);
+    args.param = args.count < args.func->func_info.param_count ? args.param + 1 : nullptr;
+}
 
-        case T_DEC_CONST:
-        case T_HEX_CONST:
-        case T_FLOAT_CONST:
-        case T_CHAR_CONST:
-            return C();
-            
-        case T_LPAREN: {
-            advance();
-            DataType type = V();
-            consume(T_RPAREN, "Ожидалась ')' для закрытия выражения в скобках.");
-            return type;
+void Parser::finishArguments(const CallArgs& args) {
+    if (args.func != nullptr && !args.count_reported && args.count != args.func->func_info.param_count) {
+        semanticError("Неверное количество аргументов при вызове функции '" + SemanticAnalyzer::symbolName(args.func->name) + "'");
+    }
+}
+
+// Имя в выражении: лист дерева и тип операнда
+DataType Parser::nameOperand(const Token& id_token) {
+    if (level == PARSE_SYNTAX) {
+        ast.leaf(N_NAME, TYPE_UNDEFINED, id_token.loc, id_token.atom);
+        return TYPE_UNDEFINED;
+    }
+    Symbol* sym = sem_analyzer.findSymbol(id_token.atom);
+    if (sym == nullptr || sym->category == CAT_FUNCTION) {
+        if (sym == nullptr) {
+            semanticError("Использование необъявленного идентификатора '" + std::string(id_token.text) + "'", id_token);
+        } else {
+            semanticError("Имя функции '" + std::string(id_token.text) + "' не может быть использовано в выражении.", id_token);
         }
+        ast.leaf(N_NAME, TYPE_UNDEFINED, id_token.loc, id_token.atom);
+        return TYPE_UNDEFINED;
+    }
 
-        default:
-            error("Ожидался операнд (переменная, константа или выражение в скобках).");
+    // Проверка на инициализацию
+    if ((sym->category == CAT_VARIABLE || sym->category == CAT_PARAMETER) && !sem_analyzer.isInitialized(sym)) {
+        diagnostics.warning(*source_map, id_token.loc, "Warning: На ",
+                            ": переменная '" + std::string(id_token.text) + "' используется неинициализированной.",
+                            SemanticAnalyzer::isGlobal(sym) ? sym->name : ATOM_NONE);
     }
-    return TYPE_UNDEFINED; // Не должно произойти
+
+    if (emitter != nullptr) emitter->load(sym);
+    ast.leaf(N_NAME, sym->type, id_token.loc, id_token.atom);
+    return sym->type;
 }
 
-// C -> c1 | c2 | c3 | c4
-DataType Parser::C() {
-    DataType type = TYPE_UNDEFINED;
-    switch(current_token.type) {
+DataType Parser::constantOperand(const Token& token) {
+    switch (token.type) {
         case T_DEC_CONST:
         case T_HEX_CONST:
-            type = TYPE_INT;
-            break;
+            // Значение уже проверено сканером и помещается в 32 бита
+            if (emitter != nullptr) emitter->pushInt(token.int_value);
+            ast.leaf(N_INT_CONST, TYPE_INT, token.loc, static_cast<uint32_t>(token.int_value));
+            return TYPE_INT;
         case T_FLOAT_CONST:
-            type = TYPE_DOUBLE;
-            break;
-        case T_CHAR_CONST:
-            type = TYPE_CHAR;
-            break;
-        default:
-            error("Ожидалась константа.");
+            if (emitter != nullptr) emitter->pushDouble(token.float_value);
+            ast.leaf(N_FLOAT_CONST, TYPE_DOUBLE, token.loc, ast.addFloat(token.float_value));
+            return TYPE_DOUBLE;
+        default: // T_CHAR_CONST
+            if (emitter != nullptr) emitter->pushInt(token.int_value);
+            ast.leaf(N_INT_CONST, TYPE_CHAR, token.loc, static_cast<uint32_t>(token.int_value));
+            return TYPE_CHAR;
     }
-    advance();
-    return type;
+}
+
+// Область видимости блока
+void Parser::openScope() {
+    if (level != PARSE_SYNTAX) sem_analyzer.enterScope();
+}
+
+void Parser::closeScope() {
+    if (level != PARSE_SYNTAX) sem_analyzer.leaveScope();
 }
@@ -2,69 +2,220 @@
 #define PARSER_H
 
 #include "scanner.h"
+#include "token_buffer.h"
+#include "token_queue.h"
 #include "semantic.h"
+#include "ast.h"
+#include "code_emitter.h"
+#include "diagnostics.h"
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector> 
 
+const size_t PARSER_LOOKAHEAD = 4; // Максимальная глубина peek(k)
+
+// Способ разбора. Рекурсивный спуск написан вручную; табличный разбор
+// ведёт LL(1)-таблица, которую компилятор строит по грамматике из
+// grammar.h. Проверки, сообщения семантического анализа и дерево у них
+// одинаковые; различаются тексты синтаксических ошибок и то, где разбор
+// продолжается после них. Способ по умолчанию выбирается при сборке
+// (make PARSER=table); разбор по описаниям и отложенных тел - всегда
+// рекурсивным спуском.
+enum ParserEngine {
+    ENGINE_RECURSIVE,
+    ENGINE_TABLE
+};
+
+#ifdef PARSER_TABLE
+const ParserEngine DEFAULT_PARSER_ENGINE = ENGINE_TABLE;
+#else
+const ParserEngine DEFAULT_PARSER_ENGINE = ENGINE_RECURSIVE;
+#endif
+
+// Что делает разбор помимо проверки синтаксиса (см. Parser::setLevel)
+enum ParseLevel {
+    PARSE_FULL,   // Дерево, семантический анализ, вывод таблицы символов
+    PARSE_CHECK,  // Семантический анализ без дерева и вывода таблицы
+    PARSE_SYNTAX  // Только синтаксис: анализатор не вызывается, символы не создаются
+};
+
+// Тело функции, отложенное первым проходом (см. ParallelParser)
+struct DeferredBody {
+    size_t open_index;     // '{' тела в буфере лексем
+    size_t close_index;    // Парная '}'
+    Symbol* scope;         // Область функции с параметрами
+    const SemanticAnalyzer* analyzer; // Чьё дерево: там же глобальная область
+    DiagnosticSink before; // Сообщения первого прохода между предыдущим телом и этим
+};
+
 class Parser {
 public:
     Parser(Scanner* scanner);
+    // Разбор заранее построенного буфера лексем (режим --prelex)
+    Parser(TokenBuffer* tokens);
+    // Разбор лексем, которые сканер выдаёт в другом потоке (режим --pipeline)
+    Parser(TokenQueue* queue);
+
+    // Главный метод для запуска анализа. Исключений на ошибках в программе
+    // не бросает: все найденные ошибки - в getDiagnostics().
+    void parse(ParserEngine engine = DEFAULT_PARSER_ENGINE);
+    // Синтаксическое дерево, построенное parse()
+    const Ast& getAst() const;
+    // Ошибки, найденные parse()
+    const DiagnosticSink& getDiagnostics() const;
+    DiagnosticSink& getDiagnostics();
+    const SourceMap& getSourceMap() const;
+    SemanticAnalyzer& getAnalyzer();
+    // Генерировать байт-код по ходу разбора (nullptr - не генерировать).
+    // Дерево при этом не строится и таблица символов не печатается.
+    void setEmitter(CodeEmitter* code_emitter);
+    // Уровень разбора (по умолчанию PARSE_FULL). При PARSE_SYNTAX типы
+    // выражений не выводятся, поэтому сообщаются только синтаксические ошибки.
+    void setLevel(ParseLevel parse_level);
+
+    // --- Разбор по описаниям верхнего уровня (см. IncrementalParser) ---
+    // Продолжить разбор с текущей позиции другого сканера (буфер в памяти);
+    // таблица символов сохраняется
+    void restart(Scanner* scanner);
+    // Разобрать одно описание верхнего уровня (вместе с пропуском лексем
+    // после ошибки в нём); false - вход исчерпан. Дерево хранит только
+    // последнее описание.
+    bool parseTopLevel();
+    SourceLoc currentLoc() const; // Начало текущей лексемы
 
-    // Главный метод для запуска анализа
-    void parse();
+    // --- Разбор тел функций отдельно от описаний (см. ParallelParser) ---
+    // Только для буфера лексем. Тела функций не разбираются, а пропускаются
+    // по парным скобкам и складываются в bodies (nullptr - разбирать на месте);
+    // имена в них интернируются, чтобы потоки только читали таблицу атомов.
+    void deferBodies(std::vector<DeferredBody>* bodies);
+    bool allBodiesDeferred() const; // false - у какого-то тела нет парной '}'
+    // Разобрать и проверить отложенное тело; true - разбор закончился ровно
+    // на его '}' вне режима паники, то есть так же, как при разборе на месте
+    bool parseBody(const DeferredBody& body);
 
 private:
-    Scanner* scanner;
+    Scanner* scanner;        // Источник лексем в потоковом режиме
+    TokenBuffer* tokens;     // Источник лексем в режиме буфера (иначе nullptr)
+    TokenQueue* queue;       // Источник лексем в режиме конвейера (иначе nullptr)
+    size_t token_index;      // Индекс следующей лексемы в буфере
+    const SourceMap* source_map; // Строка:столбец для сообщений
     Token current_token;
+    // Кольцо уже прочитанных лексем после current_token (для peek)
+    Token lookahead[PARSER_LOOKAHEAD];
+    size_t lookahead_head;
+    size_t lookahead_count;
+    TokenType previous_type; // Тип последней съеденной лексемы
+    bool panic_mode;         // После синтаксической ошибки, до синхронизации
     SemanticAnalyzer sem_analyzer;
+    Ast ast;
+    CodeEmitter* emitter;    // Генератор байт-кода (иначе nullptr)
+    ParseLevel level;
+    DiagnosticSink diagnostics;
+    std::vector<DeferredBody>* deferred_bodies; // Куда откладывать тела функций
+    bool bodies_unmatched;   // Тело без парной '}' разобрано на месте
+
+    // Явные стеки вместо рекурсии по вложенности (см. K и V)
+    struct OpenStatement {   // Открытый блок или цикл, ждущий тела
+        NodeKind kind;       // N_BLOCK или N_WHILE
+        SourceLoc loc;
+        size_t mark;         // Глубина стека построения дерева в начале блока
+        uint32_t loop_start; // Цикл: адрес условия и перехода из цикла (см. CodeEmitter)
+        uint32_t loop_exit;
+    };
+    struct PendingOp {       // Операция, ждущая операнда, или открытая скобка
+        Token op;
+        uint8_t power;       // Сила бинарной операции; 0 - скобка или унарный знак
+        bool unary;
+    };
+    std::vector<OpenStatement> open_statements;
+    std::vector<PendingOp> expr_ops;
+    std::vector<DataType> expr_types;
 
     // Вспомогательные методы
     void advance(); // Получить следующий токен от сканера
+    Token fetch();  // Прочитать лексему из источника (сканер, буфер или конвейер)
+    const Token& peek(size_t k); // k-я лексема после текущей (1 <= k <= PARSER_LOOKAHEAD)
     void consume(TokenType expected, const std::string& error_message); // Проверить и "съесть" токен
-    void error(const std::string& message); // Вывести сообщение об ошибке
+    void error(const std::string& message);         // Синтаксическая ошибка: сообщить и войти в режим паники
+    void semanticError(const std::string& message); // Семантическая ошибка: сообщить и продолжить
+    void semanticError(const std::string& message, const Token& at); // То же на лексеме at
+    void synchronize(bool top_level);               // Выйти из режима паники в точке синхронизации
 
     // --- Функции для нетерминалов ---
+    // Каждый разобранный оператор, описание или выражение кладёт ровно один
+    // узел на стек построения дерева (ast.leaf / ast.node), в том числе при
+    // ошибке (N_ERROR). После синтаксической ошибки разбор не прерывается:
+    // функции доходят до конца, не съедая неожиданных лексем, а списки
+    // операторов и описаний пропускают лексемы до точки синхронизации.
     // Общая структура программы
     void S(); // <программа>
+    void finishProgram();
     void T(); // <список_описаний>
+    void topLevelItem();
     void W(); // <описание>
 
     // Описания
     void D(); // <описание_данных>
     void F(); // <описание_функции>
+    void functionBody(); // {K} тела функции
+    void deferBody();
     DataType Tp(); // <тип>
     void Z(DataType type); // <список_переменных>
 
     // Параметры функции
-    std::vector<Param*> G(); // <параметры>
-    void Zf(std::vector<Param*>& params); // <список_параметров>
-    Param* Ps(); // <один_параметр>
+    std::vector<Param> G(); // <параметры>
+    void Zf(std::vector<Param>& params); // <список_параметров>
+    Param Ps(); // <один_параметр>
 
     // Операторы
     void O(); // <оператор>
-    void Q(); // <составной_оператор>
-    void K(); // <список_операторов>
+    void Q(); // <составной_оператор>: открыть блок
+    void K(); // <список_операторов> со всеми вложенными
     void P(); // <оператор_присваивания>
-    void U(); // <оператор_цикла>
+    void U(); // <оператор_цикла>: заголовок и открытие тела
     void H(); // <вызов_функции>
 
     // Параметры вызова функции
     void L(Symbol* func_sym); // <входные_параметры>
     void M(Symbol* func_sym); // <список_входных_параметров>
     
-    // Выражения (по уровням приоритета)
-    DataType V();  // <выражение>
-    DataType Vx(); // <выражение_xor>
-    DataType Va(); // <выражение_и>
-    DataType Ve(); // <выражение_равенства>
-    DataType Vr(); // <выражение_отношения>
-    DataType Vs(); // <выражение_сдвига>
-    DataType A();  // <слагаемое>
-    DataType B();  // <множитель>
-    DataType Vu(); // <унарное_выражение>
-    DataType E();  // <эл.выр.>
+    // Выражения
+    DataType V();  // <выражение>, включая унарные знаки и скобки
+    DataType E();  // <эл.выр.> без скобок
+    void reduceBinary();
+    void reduceUnary();
     DataType C();  // <константа>
+
+    // --- Семантические действия, общие для обоих способов разбора ---
+    struct CallArgs {        // Сверка аргументов вызова с параметрами
+        Symbol* func;        // nullptr - функция неизвестна
+        const Param* param;  // Параметр для следующего аргумента
+        int count;
+        bool count_reported;
+    };
+    Symbol* declareVariable(const Token& id_token, DataType type, bool& added);
+    void initializeVariable(Symbol* var, DataType expr_type, const Token& id_token);
+    void finishVariable(Symbol* var, bool added, const Token& id_token, DataType type, size_t init_count);
+    Symbol* declareFunction(Atom name, const std::vector<Param>& params, bool& added);
+    void finishFunction(Symbol* func, bool added);
+    Symbol* assignTarget(const Token& id_token);
+    DataType finishAssignment(Symbol* var_sym, DataType right_type, const Token& id_token);
+    uint32_t checkCondition(DataType cond_type);
+    Symbol* callTarget(const Token& id_token);
+    void checkNoArguments(Symbol* func_sym);
+    void checkArgument(CallArgs& args, DataType arg_type);
+    void finishArguments(const CallArgs& args);
+    DataType nameOperand(const Token& id_token);
+    DataType constantOperand(const Token& token);
+    void openScope();
+    void closeScope();
+
+    // --- Табличный разбор (parser_table.cpp) ---
+    struct TableState;
+    void parseTable();
+    void tableAction(uint8_t action, TableState& state);
+    void tableError(const std::string& message, TableState& state);
 };
 
 #endif // PARSER_H
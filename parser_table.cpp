@@ -0,0 +1,388 @@
+#include "parser.h"
+#include "grammar.h"
+
+namespace {
+
+// Лексема в тексте сообщения "ожидалось ..."
+const char* tokenSpelling(size_t type) {
+    switch (type) {
+        case T_VOID: return "'void'";
+        case T_SHORT: return "'short'";
+        case T_LONG: return "'long'";
+        case T_INT: return "'int'";
+        case T_DOUBLE: return "'double'";
+        case T_CHAR: return "'char'";
+        case T_WHILE: return "'while'";
+        case T_MAIN: return "'main'";
+        case T_IDENT: return "идентификатор";
+        case T_DEC_CONST:
+        case T_HEX_CONST:
+        case T_FLOAT_CONST:
+        case T_CHAR_CONST: return "константа";
+        case T_BIT_OR: return "'|'";
+        case T_BIT_XOR: return "'^'";
+        case T_BIT_AND: return "'&'";
+        case T_EQ: return "'=='";
+        case T_NE: return "'!='";
+        case T_LT: return "'<'";
+        case T_LE: return "'<='";
+        case T_GT: return "'>'";
+        case T_GE: return "'>='";
+        case T_LSHIFT: return "'<<'";
+        case T_RSHIFT: return "'>>'";
+        case T_PLUS: return "'+'";
+        case T_MINUS: return "'-'";
+        case T_MUL: return "'*'";
+        case T_DIV: return "'/'";
+        case T_MOD: return "'%'";
+        case T_ASSIGN: return "'='";
+        case T_SEMICOLON: return "';'";
+        case T_COMMA: return "','";
+        case T_LPAREN: return "'('";
+        case T_RPAREN: return "')'";
+        case T_LBRACE: return "'{'";
+        case T_RBRACE: return "'}'";
+        case T_EOF: return "конец файла";
+        default: return "лексема";
+    }
+}
+
+// Сообщение строится по строке таблицы предсказаний (или по одному
+// терминалу), поэтому само следует за грамматикой
+std::string expectedMessage(uint64_t expected) {
+    std::string list;
+    size_t count = 0;
+    for (size_t k = 0; k < GRAMMAR_TERMINALS; ++k) {
+        if ((expected & (uint64_t(1) << k)) == 0) continue;
+        std::string spelling = tokenSpelling(k);
+        if (list.find(spelling) != std::string::npos) continue; // Константы разных видов
+        if (count++ > 0) list += ", ";
+        list += spelling;
+    }
+    return (count == 1 ? "Ожидалось: " : "Ожидалось одно из: ") + list + ".";
+}
+
+uint64_t expectedTokens(Nonterminal n) {
+    uint64_t set = 0;
+    for (size_t k = 0; k < GRAMMAR_TERMINALS; ++k) {
+        if (predict_table.rule[n][k] != NO_RULE) set |= uint64_t(1) << k;
+    }
+    return set;
+}
+
+} // namespace
+
+// Стек символов грамматики и стеки значений семантических действий.
+// Значения, которые рекурсивный спуск держит в локальных переменных
+// функций-нетерминалов, здесь лежат на стеках кадров.
+struct Parser::TableState {
+    struct OpenNode {        // Узел, дети которого ещё строятся
+        SourceLoc loc;
+        size_t mark;
+    };
+    struct VarFrame {
+        Symbol* var;
+        Token id;
+        bool added;
+        size_t init_count;
+    };
+    struct FunctionFrame {
+        Token id;
+        std::vector<Param> params;
+        Symbol* func;        // nullptr - заголовок ещё не разобран
+        bool added;
+    };
+    struct CallFrame {
+        Token id;
+        CallArgs args;
+        size_t mark;
+    };
+    struct AssignFrame {
+        Token id;
+        Symbol* var;
+    };
+    struct LoopFrame {       // Адреса цикла в байт-коде (см. CodeEmitter)
+        uint32_t start;
+        uint32_t exit;
+    };
+    // Точка восстановления: начало описания (T) или оператора (K).
+    // Синтаксическая ошибка возвращает все стеки к ближайшей точке,
+    // заворачивает построенное с неё в N_ERROR и пропускает лексемы, как
+    // synchronize у рекурсивного спуска.
+    struct RecoveryPoint {
+        size_t depth;        // Высота стека символов с T или K на вершине
+        bool top_level;
+        SourceLoc loc;
+        size_t ast_mark;
+        size_t opened, decl_types, vars, functions, calls, assigns, loops, expr_types, expr_ops, scopes;
+    };
+
+    std::vector<GrammarSymbol> stack;
+    Token matched;           // Последняя сопоставленная лексема
+    std::vector<OpenNode> opened;
+    std::vector<DataType> decl_types;
+    std::vector<VarFrame> vars;
+    std::vector<FunctionFrame> functions;
+    std::vector<CallFrame> calls;
+    std::vector<AssignFrame> assigns;
+    std::vector<LoopFrame> loops;
+    std::vector<RecoveryPoint> points;
+    size_t scopes = 0;       // Открытые области видимости
+    SourceLoc last_error = NO_SOURCE_LOC;
+};
+
+// Табличный LL(1)-разбор: на вершине стека терминал - сверить с текущей
+// лексемой, нетерминал - заменить правой частью правила из таблицы
+// предсказаний, действие - выполнить. Разбор не рекурсивный, глубина
+// вложенности ограничена только памятью.
+void Parser::parseTable() {
+    TableState state;
+    // У S одно правило; лексема, с которой не начинается ни одно описание,
+    // - ошибка уже в T, где есть точка восстановления
+    const GrammarRule& start = grammar_rules[0];
+    for (size_t i = start.length; i > 0; --i) state.stack.push_back(start.rhs[i - 1]);
+    while (!state.stack.empty()) {
+        GrammarSymbol symbol = state.stack.back();
+        state.stack.pop_back();
+
+        if (isTerminal(symbol)) {
+            if (current_token.type == symbol) {
+                state.matched = current_token;
+                advance();
+            } else {
+                tableError(expectedMessage(uint64_t(1) << symbol), state);
+            }
+            continue;
+        }
+        if (!isNonterminal(symbol)) {
+            tableAction(static_cast<uint8_t>(symbol - GRAMMAR_ACTION_BASE), state);
+            continue;
+        }
+
+        Nonterminal n = static_cast<Nonterminal>(symbol - GRAMMAR_NONTERMINAL_BASE);
+        if (n == NT_T || n == NT_K) {
+            // Начало описания или оператора. Рекурсивный T или K правой
+            // части займёт это же место стека, поэтому точка следующего
+            // заменит эту.
+            size_t depth = state.stack.size() + 1;
+            while (!state.points.empty() && state.points.back().depth >= depth) state.points.pop_back();
+            state.points.push_back({depth, n == NT_T, current_token.loc, ast.mark(),
+                                    state.opened.size(), state.decl_types.size(), state.vars.size(),
+                                    state.functions.size(), state.calls.size(), state.assigns.size(),
+                                    state.loops.size(), expr_types.size(), expr_ops.size(), state.scopes});
+        }
+        uint8_t index = predict_table.rule[n][current_token.type];
+        if (index == NO_RULE) {
+            state.stack.push_back(symbol);
+            tableError(expectedMessage(expectedTokens(n)), state);
+            continue;
+        }
+        const GrammarRule& r = grammar_rules[index];
+        for (size_t i = r.length; i > 0; --i) state.stack.push_back(r.rhs[i - 1]);
+    }
+}
+
+void Parser::tableError(const std::string& message, TableState& state) {
+    error(message);
+
+    // Ближайшая точка, чей T или K ещё на стеке; в конце файла - верхний
+    // уровень, где конец файла допустим
+    bool at_eof = current_token.type == T_EOF;
+    while (state.points.size() > 1 &&
+           (state.points.back().depth > state.stack.size() || (at_eof && !state.points.back().top_level))) {
+        state.points.pop_back();
+    }
+    TableState::RecoveryPoint point = state.points.back();
+
+    state.stack.resize(point.depth);
+    while (state.vars.size() > point.vars) {
+        if (!state.vars.back().added) sem_analyzer.freeSymbol(state.vars.back().var);
+        state.vars.pop_back();
+    }
+    while (state.functions.size() > point.functions) {
+        TableState::FunctionFrame& frame = state.functions.back();
+        if (frame.func != nullptr && !frame.added) sem_analyzer.freeSymbol(frame.func);
+        state.functions.pop_back();
+    }
+    for (; state.scopes > point.scopes; --state.scopes) closeScope();
+    state.opened.resize(point.opened);
+    state.decl_types.resize(point.decl_types);
+    state.calls.resize(point.calls);
+    state.assigns.resize(point.assigns);
+    state.loops.resize(point.loops);
+    expr_types.resize(point.expr_types);
+    expr_ops.resize(point.expr_ops);
+    ast.node(N_ERROR, TYPE_UNDEFINED, point.loc, ast.mark() - point.ast_mark);
+
+    SourceLoc error_loc = current_token.loc;
+    synchronize(point.top_level);
+    // Ошибка повторилась на той же лексеме, а пропускать нечего: без
+    // лексемы разбор бы не сдвинулся
+    if (current_token.loc == error_loc && error_loc == state.last_error && !at_eof) advance();
+    state.last_error = error_loc;
+}
+
+void Parser::tableAction(uint8_t action, TableState& state) {
+    switch (action) {
+        case ACT_PROGRAM_BEGIN:
+        case ACT_DATA_BEGIN:
+            state.opened.push_back({current_token.loc, ast.mark()});
+            break;
+        case ACT_PROGRAM_END: {
+            TableState::OpenNode program = state.opened.back();
+            state.opened.pop_back();
+            ast.node(N_PROGRAM, TYPE_UNDEFINED, program.loc, ast.mark() - program.mark);
+            finishProgram();
+            break;
+        }
+        case ACT_DATA_END: {
+            TableState::OpenNode data = state.opened.back();
+            state.opened.pop_back();
+            ast.node(N_DATA, state.decl_types.back(), data.loc, ast.mark() - data.mark);
+            state.decl_types.pop_back();
+            break;
+        }
+        case ACT_TYPE:
+            state.decl_types.push_back(SemanticAnalyzer::tokenTypeToDataType(state.matched.type));
+            break;
+
+        case ACT_VAR: {
+            bool added;
+            Symbol* var = declareVariable(current_token, state.decl_types.back(), added);
+            state.vars.push_back({var, current_token, added, 0});
+            break;
+        }
+        case ACT_VAR_INIT: {
+            TableState::VarFrame& frame = state.vars.back();
+            initializeVariable(frame.var, expr_types.back(), frame.id);
+            expr_types.pop_back();
+            frame.init_count = 1;
+            break;
+        }
+        case ACT_VAR_END: {
+            TableState::VarFrame frame = state.vars.back();
+            state.vars.pop_back();
+            finishVariable(frame.var, frame.added, frame.id, state.decl_types.back(), frame.init_count);
+            break;
+        }
+
+        case ACT_FUNC_NAME:
+            state.functions.push_back({state.matched, {}, nullptr, false});
+            break;
+        case ACT_PARAM: {
+            DataType type = state.decl_types.back();
+            state.decl_types.pop_back();
+            state.functions.back().params.push_back(Param{state.matched.atom, type});
+            ast.leaf(N_PARAM, type, state.matched.loc, state.matched.atom);
+            break;
+        }
+        case ACT_FUNC_DECLARE: {
+            TableState::FunctionFrame& frame = state.functions.back();
+            frame.func = declareFunction(frame.id.atom, frame.params, frame.added);
+            state.scopes++;
+            break;
+        }
+        case ACT_BODY_BEGIN:
+            state.opened.push_back({state.matched.loc, ast.mark()});
+            break;
+        case ACT_BODY_END:
+        case ACT_BLOCK_END: {
+            TableState::OpenNode block = state.opened.back();
+            state.opened.pop_back();
+            ast.node(N_BLOCK, TYPE_UNDEFINED, block.loc, ast.mark() - block.mark);
+            if (action == ACT_BLOCK_END) {
+                closeScope();
+                state.scopes--;
+                if (emitter != nullptr) emitter->closeBlock();
+            }
+            break;
+        }
+        case ACT_FUNC_END: {
+            TableState::FunctionFrame& frame = state.functions.back();
+            finishFunction(frame.func, frame.added);
+            state.scopes--;
+            ast.node(N_FUNCTION, TYPE_VOID, frame.id.loc, frame.params.size() + 1, frame.id.atom);
+            state.functions.pop_back();
+            break;
+        }
+
+        case ACT_EMPTY:
+            ast.leaf(N_EMPTY, TYPE_UNDEFINED, state.matched.loc);
+            break;
+        case ACT_ASSIGN_BEGIN:
+            state.assigns.push_back({state.matched, assignTarget(state.matched)});
+            break;
+        case ACT_ASSIGN_END: {
+            TableState::AssignFrame frame = state.assigns.back();
+            state.assigns.pop_back();
+            DataType type = finishAssignment(frame.var, expr_types.back(), frame.id);
+            expr_types.pop_back();
+            ast.node(N_ASSIGN, type, frame.id.loc, 1, frame.id.atom);
+            break;
+        }
+        case ACT_CALL_BEGIN: {
+            Symbol* func = callTarget(state.matched);
+            CallArgs args = {func, func != nullptr ? func->func_info.params : nullptr, 0, false};
+            state.calls.push_back({state.matched, args, ast.mark()});
+            break;
+        }
+        case ACT_NO_ARGS:
+            checkNoArguments(state.calls.back().args.func);
+            break;
+        case ACT_ARG:
+            checkArgument(state.calls.back().args, expr_types.back());
+            expr_types.pop_back();
+            break;
+        case ACT_ARGS_END:
+            finishArguments(state.calls.back().args);
+            break;
+        case ACT_CALL_END: {
+            TableState::CallFrame frame = state.calls.back();
+            state.calls.pop_back();
+            if (emitter != nullptr && frame.args.func != nullptr) emitter->call(frame.args.func);
+            ast.node(N_CALL, TYPE_VOID, frame.id.loc, ast.mark() - frame.mark, frame.id.atom);
+            break;
+        }
+
+        case ACT_BLOCK_BEGIN:
+            openScope();
+            state.scopes++;
+            if (emitter != nullptr) emitter->openBlock();
+            state.opened.push_back({state.matched.loc, ast.mark()});
+            break;
+        case ACT_WHILE_BEGIN:
+            state.opened.push_back({state.matched.loc, ast.mark()});
+            // Условие начинается со следующей команды
+            state.loops.push_back({emitter != nullptr ? emitter->here() : 0, 0});
+            break;
+        case ACT_WHILE_COND:
+            state.loops.back().exit = checkCondition(expr_types.back());
+            expr_types.pop_back();
+            break;
+        case ACT_WHILE_END: {
+            TableState::OpenNode loop = state.opened.back();
+            state.opened.pop_back();
+            if (emitter != nullptr) emitter->loopEnd(state.loops.back().start, state.loops.back().exit);
+            state.loops.pop_back();
+            ast.node(N_WHILE, TYPE_UNDEFINED, loop.loc, 2);
+            break;
+        }
+
+        // Выражения - на тех же стеках expr_ops и expr_types, что у V
+        case ACT_OP:
+            expr_ops.push_back({state.matched, 0, false});
+            break;
+        case ACT_BINARY:
+            reduceBinary();
+            break;
+        case ACT_UNARY:
+            reduceUnary();
+            break;
+        case ACT_NAME:
+            expr_types.push_back(nameOperand(current_token));
+            break;
+        case ACT_CONST:
+            expr_types.push_back(constantOperand(state.matched));
+            break;
+    }
+}
@@ -1,229 +1,439 @@
 #include "scanner.h"
+#include "charscan.h"
+#include "utf8.h"
+#include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
 
-// Конструктор инициализирует состояние сканера и заполняет таблицу ключевых слов
-Scanner::Scanner(const std::string& source) 
-    : source_code(source), current_pos(0), current_line(1) {
-    // Заполняем карту ключевых слов для быстрой проверки
-    keywords["void"] = T_VOID;
-    keywords["short"] = T_SHORT;
-    keywords["long"] = T_LONG;
-    keywords["int"] = T_INT;
-    keywords["double"] = T_DOUBLE;
-    keywords["char"] = T_CHAR;
-    keywords["while"] = T_WHILE;
-    keywords["main"] = T_MAIN;
+// Конструктор для исходного кода, целиком лежащего в памяти
+Scanner::Scanner(std::string_view source, AtomTable* atoms, bool utf8)
+    : source_code(source), window_base(0), current_pos(0), token_start(0), source_map(source), atoms(atoms),
+      utf8(utf8), utf8_checked(source.length()),
+      input_fd(-1), input_eof(true), next_text_slot(0), line_cursor_pos(0), line_cursor_line(1) {
+    if (source.length() > UINT32_MAX) {
+        throw std::runtime_error("Файл больше 4 ГБ: позиции лексем не помещаются в 32 бита, используйте --stream.");
+    }
+    initEngine();
+}
+
+// Конструктор потокового режима: окно пусто и заполняется при первом обращении
+Scanner::Scanner(int fd, size_t window_size, AtomTable* atoms, bool utf8)
+    : source_code(), window_base(0), current_pos(0), token_start(0), source_map(), atoms(atoms),
+      utf8(utf8), utf8_checked(0),
+      input_fd(fd), reader(fd), input_eof(false), window(window_size), next_text_slot(0),
+      line_cursor_pos(0), line_cursor_line(1) {
+    initEngine();
+}
+
+bool Scanner::isStreaming() const {
+    return input_fd >= 0;
+}
+
+const SourceMap& Scanner::getSourceMap() const {
+    return source_map;
+}
+
+void Scanner::countLines(size_t pos) {
+    const char* begin = source_code.data();
+    line_cursor_line += static_cast<SourceLoc>(std::count(begin + (line_cursor_pos - window_base),
+                                                          begin + (pos - window_base), '\n'));
+    line_cursor_pos = pos;
+}
+
+// В памяти позиция - смещение, строка вычисляется лишь для диагностики.
+// В потоке смещения не помещаются в 32 бита и файл нельзя перечитать,
+// поэтому позиция - номер строки.
+SourceLoc Scanner::locate(size_t pos) {
+    if (input_fd < 0) return static_cast<SourceLoc>(pos);
+    countLines(pos);
+    return line_cursor_line;
+}
+
+// Дочитывание потока. Всё, что лежит до начала текущей лексемы, из окна
+// выбрасывается, начатая лексема сдвигается в начало окна.
+bool Scanner::refill() {
+    if (input_eof) return false;
+
+    size_t drop = std::min(token_start, current_pos) - window_base;
+    // Непроверенный хвост (начало символа UTF-8 на границе окна) остаётся в окне
+    if (utf8) drop = std::min(drop, utf8_checked - window_base);
+    size_t kept = source_code.length() - drop;
+    if (line_cursor_pos < window_base + drop) countLines(window_base + drop);
+    if (drop > 0) {
+        std::memmove(window.data(), window.data() + drop, kept);
+        window_base += drop;
+    }
+    if (kept == window.size()) {
+        throw std::runtime_error("Лексема на строке " + std::to_string(locate(token_start)) +
+                                 " длиннее окна чтения (" + std::to_string(window.size()) + " байт).");
+    }
+
+    size_t got = reader.read(window.data() + kept, window.size() - kept);
+    source_code = std::string_view(window.data(), kept + got);
+    if (got == 0) input_eof = true;
+    if (utf8) checkUtf8();
+    return got != 0;
+}
+
+// Проверка UTF-8 от utf8_checked до конца окна. Символ, обрезанный границей
+// окна, допустим, пока поток не кончился: он проверится после дочитывания.
+void Scanner::checkUtf8() {
+    const char* begin = source_code.data();
+    const char* end = begin + source_code.length();
+    const char* stop = validateUtf8(begin + (utf8_checked - window_base), end);
+    utf8_checked = window_base + (stop - begin);
+    if (stop != end && (input_eof || !isTruncatedUtf8(stop, end))) {
+        SourceLoc line = utf8_checked >= line_cursor_pos ? locate(utf8_checked) : line_cursor_line;
+        throw std::runtime_error("Некорректная последовательность UTF-8 на строке " + std::to_string(line) + ".");
+    }
+}
+
+bool Scanner::atEnd() {
+    return current_pos - window_base >= source_code.length() && !refill();
+}
+
+std::string_view Scanner::textAt(size_t pos, size_t length) {
+    return source_code.substr(pos - window_base, length);
+}
+
+// В потоковом режиме окно перезаписывается, поэтому текст лексемы копируется
+// в одну из строк кольца (память строк переиспользуется)
+std::string_view Scanner::keepText(std::string_view text) {
+    const char* data = text.data();
+    std::less<const char*> before;
+    if (before(data, window.data()) || !before(data, window.data() + window.size())) {
+        return text; // Статическая строка, а не текст из окна
+    }
+    std::string& slot = text_slots[next_text_slot];
+    next_text_slot = (next_text_slot + 1) % STREAM_TEXT_SLOTS;
+    slot.assign(data, text.length());
+    return slot;
+}
+
+Token Scanner::getNextToken() {
+    Token token = lexToken();
+    if (atoms && (token.type == T_IDENT || token.type == T_MAIN)) {
+        token.atom = atoms->intern(token.text);
+    }
+    if (input_fd >= 0) token.text = keepText(token.text);
+    return token;
 }
 
 // "Заглядывание" вперед
 char Scanner::peek() {
-    if (current_pos >= source_code.length()) return '\0';
-    return source_code[current_pos];
+    if (atEnd()) return '\0';
+    return source_code[current_pos - window_base];
 }
 
 // Чтение символа с продвижением
 char Scanner::advance() {
-    if (current_pos < source_code.length()) {
-        if (source_code[current_pos] == '\n') {
-            current_line++;
-        }
-        return source_code[current_pos++];
+    if (!atEnd()) {
+        return source_code[current_pos++ - window_base];
     }
     return '\0';
 }
 
-// Пропуск пробелов, табуляций, новых строк и комментариев
+// Пропуск пробелов, табуляций, новых строк и комментариев.
+// Длинные серии пробелов и тела комментариев пропускаются векторными ядрами;
+// перед дочитыванием окна пропущенное можно выбросить (token_start = current_pos).
 void Scanner::skipWhitespaceAndComments() {
+    bool in_comment = false;
     while (true) {
-        char c = peek();
-        if (isspace(c)) { // Пробел, \t, \n, \r
-            advance();
-        } else if (c == '/' && (current_pos + 1 < source_code.length() && source_code[current_pos + 1] == '/')) {
-            // Комментарий "//", пропускаем до конца строки
-            while (peek() != '\n' && peek() != '\0') {
-                advance();
+        const char* begin = source_code.data();
+        const char* end = begin + source_code.length();
+        const char* p = begin + (current_pos - window_base);
+
+        if (in_comment) {
+            p = scanToNewline(p, end); // Сам '\n' - пробельный, его пропустит scanSpaces
+            current_pos = window_base + (p - begin);
+            token_start = current_pos;
+            if (p == end) {
+                if (refill()) continue; // Комментарий продолжается в следующем окне
+                break;
             }
-        } else {
-            break; // Нашли значащий символ
+            in_comment = false;
+            continue;
+        }
+
+        p = scanSpaces(p, end);
+        current_pos = window_base + (p - begin);
+        token_start = current_pos;
+        if (p == end || (p[0] == '/' && end - p < 2)) {
+            if (refill()) continue; // Серия пробелов или "/" на границе окна
+            if (p == end) break;
+        }
+        if (end - p >= 2 && p[0] == '/' && p[1] == '/') {
+            // Комментарий "//", пропускаем до конца строки
+            current_pos += 2;
+            in_comment = true;
+            continue;
+        }
+        break; // Нашли значащий символ
+    }
+}
+
+size_t Scanner::peekCodePoint(uint32_t* cp) {
+    if (atEnd()) return 0;
+    size_t rel = current_pos - window_base;
+    if (static_cast<unsigned char>(source_code[rel]) < 0x80) return 0;
+    if (source_code.length() - rel < 4 && refill()) rel = current_pos - window_base; // Символ на границе окна
+    const char* end = source_code.data() + source_code.length();
+    return decodeUtf8(source_code.data() + rel, end, cp);
+}
+
+size_t Scanner::identEnd() {
+    current_pos = runEnd(scanIdent);
+    uint32_t cp;
+    size_t length;
+    while (utf8 && (length = peekCodePoint(&cp)) != 0 && isXidContinue(cp)) {
+        current_pos += length;
+        current_pos = runEnd(scanIdent);
+    }
+    return current_pos;
+}
+
+// Символ вне ASCII: начало идентификатора (XID_Start) или ошибочная лексема из одного символа
+Token Scanner::lexNonAscii(size_t start_pos, SourceLoc start_loc) {
+    uint32_t cp = 0;
+    size_t length = peekCodePoint(&cp);
+    current_pos += length;
+    if (!isXidStart(cp)) {
+        return {T_ERROR, textAt(start_pos, length), start_loc};
+    }
+    current_pos = identEnd();
+    std::string_view text = textAt(start_pos, current_pos - start_pos);
+    if (text.length() > MAX_LEX_LENGTH) {
+        return {T_ERROR, text, start_loc}; // Слишком длинный идентификатор (длина в байтах)
+    }
+    return {T_IDENT, text, start_loc};
+}
+
+// Позиция конца серии символов, найденной ядром scan начиная с current_pos
+size_t Scanner::runEnd(const char* (*scan)(const char*, const char*)) {
+    while (true) {
+        const char* begin = source_code.data();
+        const char* end = begin + source_code.length();
+        const char* p = scan(begin + (current_pos - window_base), end);
+        current_pos = window_base + (p - begin);
+        if (p < end || !refill()) return current_pos;
+    }
+}
+
+// Код символа после '\' в символьной константе
+static int64_t escapeValue(char c) {
+    switch (c) {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case '0': return '\0';
+        case 'a': return '\a';
+        case 'b': return '\b';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        default: return static_cast<unsigned char>(c); // '\\', '\'', '\"' и прочие - сам символ
+    }
+}
+
+bool decodeLiteral(Token& token, std::string_view lexeme) {
+    const char* first = lexeme.data();
+    const char* last = first + lexeme.length();
+    switch (token.type) {
+        case T_DEC_CONST: {
+            uint64_t value;
+            std::from_chars_result r = std::from_chars(first, last, value, 10);
+            if (r.ec != std::errc() || value > uint64_t(MAX_DEC_CONST)) return false;
+            token.int_value = static_cast<int64_t>(value);
+            return true;
+        }
+        case T_HEX_CONST: {
+            uint64_t value;
+            std::from_chars_result r = std::from_chars(first + 2, last, value, 16); // Без "0x"
+            if (r.ec != std::errc() || value > uint64_t(MAX_HEX_CONST)) return false;
+            token.int_value = static_cast<int64_t>(value);
+            return true;
+        }
+        case T_FLOAT_CONST: {
+            // Переполнение и потеря значения (слишком малое число) - ошибка диапазона
+            std::from_chars_result r = std::from_chars(first, last, token.float_value);
+            return r.ec == std::errc();
         }
+        case T_CHAR_CONST:
+            // 'c' или '\c'
+            token.int_value = lexeme[1] == '\\' ? escapeValue(lexeme[2])
+                                               : static_cast<unsigned char>(lexeme[1]);
+            return true;
+        default:
+            return true;
     }
 }
 
+#ifndef SCANNER_DFA
+
+// Заполнение таблицы ключевых слов
+void Scanner::initEngine() {
+    keywords["void"] = T_VOID;
+    keywords["short"] = T_SHORT;
+    keywords["long"] = T_LONG;
+    keywords["int"] = T_INT;
+    keywords["double"] = T_DOUBLE;
+    keywords["char"] = T_CHAR;
+    keywords["while"] = T_WHILE;
+    keywords["main"] = T_MAIN;
+}
+
 // Основной метод, реализующий логику конечного автомата
-Token Scanner::getNextToken() {
+Token Scanner::lexToken() {
     skipWhitespaceAndComments();
 
     size_t start_pos = current_pos;
-    int start_line = current_line;
+    token_start = start_pos;
+    SourceLoc start_loc = locate(start_pos);
 
-    if (current_pos >= source_code.length()) {
-        return {T_EOF, "EOF", start_line};
+    if (atEnd()) {
+        return {T_EOF, "EOF", start_loc};
     }
 
     char c = advance();
 
+    // 0. Символ вне ASCII во входе UTF-8
+    if (utf8 && static_cast<unsigned char>(c) >= 0x80) {
+        current_pos = start_pos;
+        return lexNonAscii(start_pos, start_loc);
+    }
+
     // 1. Ветка для идентификаторов и ключевых слов (состояние R на диаграмме)
-    if (isalpha(c) || c == '_') {
-        while (isalnum(peek()) || peek() == '_') {
-            if (current_pos - start_pos < MAX_LEX_LENGTH) {
-                advance();
-            } else {
-                // Если длина превышена, просто двигаемся дальше, не сохраняя символы
-                while (isalnum(peek()) || peek() == '_') {
-                    advance();
-                }
-                // Возвращаем ошибку о слишком длинном идентификаторе
-                std::string text = source_code.substr(start_pos, current_pos - start_pos);
-                return {T_ERROR, text, start_line};
-            }
+    if (isalpha(static_cast<unsigned char>(c)) || c == '_') {
+        current_pos = identEnd();
+        if (current_pos - start_pos > MAX_LEX_LENGTH) {
+            // Возвращаем ошибку о слишком длинном идентификаторе
+            std::string_view text = textAt(start_pos, current_pos - start_pos);
+            return {T_ERROR, text, start_loc};
         }
-        std::string text = source_code.substr(start_pos, current_pos - start_pos);
+        std::string_view text = textAt(start_pos, current_pos - start_pos);
         auto it = keywords.find(text);
         if (it != keywords.end()) {
-            return {it->second, text, start_line}; // Нашли ключевое слово
+            return {it->second, text, start_loc}; // Нашли ключевое слово
         }
-        return {T_IDENT, text, start_line}; // Это идентификатор
+        return {T_IDENT, text, start_loc}; // Это идентификатор
     }
 
     // 2. Ветка для числовых констант
-    if (isdigit(c) || c == '.') {
+    if (isdigit(static_cast<unsigned char>(c)) || c == '.') {
         bool isFloat = (c == '.');
 
-        if (isFloat && !isdigit(peek())) {
-            return {T_ERROR, ".", start_line}; // Это одиночная точка, сразу возвращаем ошибку
+        if (isFloat && !isdigit(static_cast<unsigned char>(peek()))) {
+            return {T_ERROR, ".", start_loc}; // Это одиночная точка, сразу возвращаем ошибку
         }
 
-        size_t digit_count = 0;
+        TokenType type = T_DEC_CONST;
         // Обработка 16-ричных констант (0x...)
         if (c == '0' && (peek() == 'x' || peek() == 'X')) {
             advance(); // съедаем 'x'
 
-            if (!isxdigit(peek())) {
-                std::string text = source_code.substr(start_pos, current_pos - start_pos);
-                return {T_ERROR, text, start_line}; // Ошибка: "0x" без цифр
+            if (!isxdigit(static_cast<unsigned char>(peek()))) {
+                std::string_view text = textAt(start_pos, current_pos - start_pos);
+                return {T_ERROR, text, start_loc}; // Ошибка: "0x" без цифр
             }
 
-            size_t hex_start_pos = current_pos;
-            while (isxdigit(peek())) {
-                advance();
-            }
-            digit_count = current_pos - hex_start_pos;
-            
-            // Проверка длины для 16-ричного числа (max 8 цифр для long)
-            if (digit_count > 8) {
-                return {T_ERROR, source_code.substr(start_pos, current_pos - start_pos), start_line};
-            }
+            current_pos = runEnd(scanHexDigits);
+            type = T_HEX_CONST;
         } else { // Обработка 10-ричных и вещественных констант
-            size_t integer_part_count = 0;
-            size_t fractional_part_count = 0;
-
             if (c != '.') {
-                // Считаем цифры в целой части
-                integer_part_count = 1; // Уже считали первую цифру
-                while (isdigit(peek())) {
-                    advance();
-                    integer_part_count++;
-                }
+                current_pos = runEnd(scanDigits); // Целая часть (первая цифра уже считана)
             }
 
             if (isFloat || peek() == '.') {
                 isFloat = true;
                 advance();
-                while (isdigit(peek())) {
-                    advance();
-                    fractional_part_count++;
-                }
-            }
-            
-            if (isFloat) {
-                // Для float/double не больше 15 знаков в каждой части
-                if (integer_part_count > 15 || fractional_part_count > 15) {
-                    return {T_ERROR, source_code.substr(start_pos, current_pos - start_pos), start_line};
-                }
-            } else {
-                // Для int/long не больше 10 знаков (макс значение 2,147,483,647)
-                if (integer_part_count > 10) {
-                     return {T_ERROR, source_code.substr(start_pos, current_pos - start_pos), start_line};
-                }
+                current_pos = runEnd(scanDigits); // Дробная часть
             }
+            if (isFloat) type = T_FLOAT_CONST;
+        }
+
+        // Значение константы и проверка диапазона ее типа
+        Token token = {type, textAt(start_pos, current_pos - start_pos), start_loc};
+        if (!decodeLiteral(token, token.text)) {
+            return {T_ERROR, token.text, start_loc};
         }
         
         // Проверка на недопустимый символ после числа
         char next_char = peek();
         // Список символов, которые МОГУТ идти после числа
-        std::string valid_followers = " \t\n\r()[]{};,+-*/%<>=&|^";
+        std::string_view valid_followers = " \t\n\r()[]{};,+-*/%<>=&|^";
 
-        if (next_char != '\0' && valid_followers.find(next_char) == std::string::npos) {
+        if (next_char != '\0' && valid_followers.find(next_char) == std::string_view::npos) {
             // Если следующий символ - не конец строки И он НЕ найден в списке допустимых,
             // то это ошибка.
-            std::string error_text = source_code.substr(start_pos, current_pos - start_pos + 1);
-            return {T_ERROR, error_text, start_line};
+            std::string_view error_text = textAt(start_pos, current_pos - start_pos + 1);
+            return {T_ERROR, error_text, start_loc};
         }
 
-        std::string text = source_code.substr(start_pos, current_pos - start_pos);
-        if (text.find("0x") != std::string::npos || text.find("0X") != std::string::npos) {
-            return {T_HEX_CONST, text, start_line};
-        }
-        if (isFloat) {
-            return {T_FLOAT_CONST, text, start_line};
-        }
-        return {T_DEC_CONST, text, start_line};
+        // peek() мог дочитать окно - текст берется заново
+        token.text = textAt(start_pos, current_pos - start_pos);
+        return token;
     }
 
     // 3. Ветка для символьных констант
     if (c == '\'') {
-        std::string text;
         if (peek() == '\\') { // Экранированный символ
             advance(); 
-            text += advance();
-        } else {
-            text += advance();
         }
+        size_t char_pos = current_pos;
+        advance();
+        size_t char_len = current_pos - char_pos;
         if (peek() == '\'') {
             advance();
-            return {T_CHAR_CONST, text, start_line};
+            Token token = {T_CHAR_CONST, {}, start_loc};
+            decodeLiteral(token, textAt(start_pos, current_pos - start_pos));
+            token.text = textAt(char_pos, char_len);
+            return token;
         }
-        return {T_ERROR, "Unclosed char literal", start_line};
+        return {T_ERROR, "Unclosed char literal", start_loc};
     }
     
     // 4. Ветка для операторов и разделителей
     switch (c) {
-        case '(': return {T_LPAREN, "(", start_line};
-        case ')': return {T_RPAREN, ")", start_line};
-        case '{': return {T_LBRACE, "{", start_line};
-        case '}': return {T_RBRACE, "}", start_line};
-        case ';': return {T_SEMICOLON, ";", start_line};
-        case ',': return {T_COMMA, ",", start_line};
-        case '+': return {T_PLUS, "+", start_line};
-        case '-': return {T_MINUS, "-", start_line};
-        case '*': return {T_MUL, "*", start_line};
-        case '/': return {T_DIV, "/", start_line};
-        case '%': return {T_MOD, "%", start_line};
-        case '|': return {T_BIT_OR, "|", start_line};
-        case '&': return {T_BIT_AND, "&", start_line};
-        case '^': return {T_BIT_XOR, "^", start_line};
+        case '(': return {T_LPAREN, "(", start_loc};
+        case ')': return {T_RPAREN, ")", start_loc};
+        case '{': return {T_LBRACE, "{", start_loc};
+        case '}': return {T_RBRACE, "}", start_loc};
+        case ';': return {T_SEMICOLON, ";", start_loc};
+        case ',': return {T_COMMA, ",", start_loc};
+        case '+': return {T_PLUS, "+", start_loc};
+        case '-': return {T_MINUS, "-", start_loc};
+        case '*': return {T_MUL, "*", start_loc};
+        case '/': return {T_DIV, "/", start_loc};
+        case '%': return {T_MOD, "%", start_loc};
+        case '|': return {T_BIT_OR, "|", start_loc};
+        case '&': return {T_BIT_AND, "&", start_loc};
+        case '^': return {T_BIT_XOR, "^", start_loc};
 
         // Двухсимвольные операторы
         case '=':
-            if (peek() == '=') { advance(); return {T_EQ, "==", start_line}; }
-            return {T_ASSIGN, "=", start_line};
+            if (peek() == '=') { advance(); return {T_EQ, "==", start_loc}; }
+            return {T_ASSIGN, "=", start_loc};
         case '!':
-            if (peek() == '=') { advance(); return {T_NE, "!=", start_line}; }
+            if (peek() == '=') { advance(); return {T_NE, "!=", start_loc}; }
             break; // Одиночный '!' - ошибка в вашем языке
         case '<':
-            if (peek() == '=') { advance(); return {T_LE, "<=", start_line}; }
-            if (peek() == '<') { advance(); return {T_LSHIFT, "<<", start_line}; }
-            return {T_LT, "<", start_line};
+            if (peek() == '=') { advance(); return {T_LE, "<=", start_loc}; }
+            if (peek() == '<') { advance(); return {T_LSHIFT, "<<", start_loc}; }
+            return {T_LT, "<", start_loc};
         case '>':
-            if (peek() == '=') { advance(); return {T_GE, ">=", start_line}; }
-            if (peek() == '>') { advance(); return {T_RSHIFT, ">>", start_line}; }
-            return {T_GT, ">", start_line};
+            if (peek() == '=') { advance(); return {T_GE, ">=", start_loc}; }
+            if (peek() == '>') { advance(); return {T_RSHIFT, ">>", start_loc}; }
+            return {T_GT, ">", start_loc};
     }
 
     // 5. Если ничего не подошло - это ошибка
-    return {T_ERROR, std::string(1, c), start_line};
+    return {T_ERROR, textAt(start_pos, 1), start_loc};
 }
 
+#endif // SCANNER_DFA
+
 size_t Scanner::getUK() {
     return current_pos;
 }
@@ -232,10 +442,6 @@ void Scanner::putUK(size_t pos) {
     current_pos = pos;
 }
 
-int Scanner::getLine() { 
-    return current_line;
-}
-
-void Scanner::setLine(int line) { 
-    current_line = line; 
+size_t Scanner::getTokenStart() {
+    return token_start;
 }
@@ -1,11 +1,21 @@
 #ifndef SCANNER_H
 #define SCANNER_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include "location.h"
+#include "intern.h"
+#include "input_reader.h"
 
 const size_t MAX_LEX_LENGTH = 100;
+const int64_t MAX_DEC_CONST = 2147483647; // Десятичная константа - int
+const int64_t MAX_HEX_CONST = 0xFFFFFFFF; // 16-ричная константа - 32 бита (long)
+const size_t STREAM_WINDOW_SIZE = 64 * 1024; // Окно чтения в потоковом режиме
+const size_t STREAM_TEXT_SLOTS = 8;          // Сколько последних лексем хранят свой текст
+                                             // (не меньше глубины просмотра парсера + 2)
 
 enum TokenType {
     // Ключевые слова
@@ -53,37 +63,105 @@ enum TokenType {
 };
 
 // Структура для хранения информации о распознанной лексеме
+// Текст лексемы - представление (view) в буфер исходного кода или в
+// статическую строку, поэтому лексема не выделяет память.
 struct Token {
     TokenType type;
-    std::string text;
-    int line; // Номер строки, где найдена лексема
+    std::string_view text;
+    SourceLoc loc; // Позиция начала лексемы (строка:столбец - через SourceMap)
+    Atom atom;     // Атом имени для T_IDENT и T_MAIN, иначе ATOM_NONE
+    union {        // Значение константы (см. decodeLiteral)
+        int64_t int_value;   // T_DEC_CONST, T_HEX_CONST, T_CHAR_CONST (код символа)
+        double float_value;  // T_FLOAT_CONST
+    };
 };
+
+// Вычисление значения константы по полному тексту лексемы (с "0x", кавычками
+// и '\'). Возвращает false, если значение не помещается в тип константы.
+bool decodeLiteral(Token& token, std::string_view lexeme);
     
-// Класс лексического анализатора (сканера)
+// Класс лексического анализатора (сканера).
+// Движок lexToken выбирается при сборке: ручной автомат (scanner.cpp)
+// или табличный ДКА (scanner_dfa.cpp, флаг SCANNER_DFA).
+//
+// Вход - либо готовый буфер в памяти, либо поток (stdin, pipe, файл),
+// читаемый окном фиксированного размера. Все позиции (getUK, getTokenStart)
+// абсолютные - от начала входа. В потоковом режиме лексема, попавшая на
+// границу окна, сдвигается в начало окна перед дочитыванием, а текст
+// выданных лексем копируется в небольшое кольцо строк, поэтому он остаётся
+// действительным для STREAM_TEXT_SLOTS последних лексем.
 class Scanner {
 public:
-    // Конструктор, принимающий исходный код в виде строки
-    Scanner(const std::string& source);
+    // Конструктор, принимающий исходный код; буфер не копируется и
+    // должен жить дольше сканера и всех выданных им лексем.
+    // Имена интернируются в atoms; nullptr - не интернировать (atom = ATOM_NONE),
+    // так работают сканеры в параллельных потоках буфера лексем.
+    // utf8 - вход в UTF-8, идентификаторы могут содержать символы XID_Start/XID_Continue;
+    // буфер в памяти должен быть заранее проверен (requireValidUtf8).
+    Scanner(std::string_view source, AtomTable* atoms = &atom_table, bool utf8 = false);
+    // Потоковый режим: чтение из дескриптора fd с ограниченной памятью.
+    // Вход, сжатый gzip/zstd, распаковывается прямо в окно (см. InputReader).
+    // В режиме UTF-8 каждая дочитанная порция проверяется сразу.
+    Scanner(int fd, size_t window_size = STREAM_WINDOW_SIZE, AtomTable* atoms = &atom_table,
+            bool utf8 = false);
 
     // Главный метод, который возвращает следующую лексему из потока
     Token getNextToken();
 
+    bool isStreaming() const;
+    // Расшифровка позиций выданных лексем
+    const SourceMap& getSourceMap() const;
+
     size_t getUK();
     void putUK(size_t pos);
-    int getLine(); 
-    void setLine(int line);
+    size_t getTokenStart(); // Смещение начала последней выданной лексемы
 
 private:
-    std::string source_code; // Строка с исходным кодом
-    size_t current_pos;      // Текущая позиция в строке (аналог 'uk' в пособии)
-    int current_line;        // Текущая строка
+    std::string_view source_code; // Исходный код или текущее окно потока (без копирования)
+    size_t window_base;      // Абсолютная позиция source_code[0]
+    size_t current_pos;      // Текущая позиция во входе (аналог 'uk' в пособии)
+    size_t token_start;      // Начало последней выданной лексемы
+    SourceMap source_map;
+    AtomTable* atoms;        // Куда интернировать имена (может быть nullptr)
+    bool utf8;               // Вход в UTF-8
+    size_t utf8_checked;     // До этой позиции поток проверен на корректность UTF-8
+
+    // Потоковый режим
+    int input_fd;            // -1 для буфера в памяти
+    InputReader reader;      // Чтение и распаковка потока
+    bool input_eof;
+    std::vector<char> window;
+    std::string text_slots[STREAM_TEXT_SLOTS];
+    size_t next_text_slot;
+    // Номера строк в потоке: '\n' считаются блоками между началами лексем
+    // и перед выбрасыванием части окна, а не посимвольно
+    size_t line_cursor_pos;
+    SourceLoc line_cursor_line;
+
+#ifndef SCANNER_DFA
+    std::map<std::string_view, TokenType> keywords; // Таблица для быстрой проверки ключевых слов
+#endif
 
-    std::map<std::string, TokenType> keywords; // Таблица для быстрой проверки ключевых слов
+    // Движок сканера
+    void initEngine();
+    Token lexToken();
 
     // Вспомогательные методы
     char peek();             // "Заглянуть" на следующий символ, не сдвигая позицию
     char advance();          // Прочитать текущий символ и сдвинуть позицию
     void skipWhitespaceAndComments(); // Пропустить все незначащие символы
+    size_t runEnd(const char* (*scan)(const char*, const char*)); // Конец серии символов одного класса
+    bool atEnd();            // Вход исчерпан (с дочитыванием окна)
+    bool refill();           // Дочитать поток в окно; false, если данных больше нет
+    std::string_view textAt(size_t pos, size_t length); // Текст по абсолютной позиции
+    std::string_view keepText(std::string_view text);   // Копия текста лексемы в потоковом режиме
+    SourceLoc locate(size_t pos);  // Позиция лексемы, начинающейся в pos
+    // UTF-8: байты >= 0x80 разбираются только здесь, ASCII идёт прежним путём
+    size_t peekCodePoint(uint32_t* cp); // Символ вне ASCII в current_pos (0 - его нет)
+    size_t identEnd();             // Конец идентификатора с учётом XID_Continue
+    Token lexNonAscii(size_t start_pos, SourceLoc start_loc); // Лексема с символа вне ASCII
+    void checkUtf8();              // Проверка новой порции потока
+    void countLines(size_t pos);   // Продвинуть счётчик строк потока до pos
 };
 
 #endif // SCANNER_H
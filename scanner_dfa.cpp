@@ -0,0 +1,374 @@
+// Альтернативный табличный движок сканера (сборка с -DSCANNER_DFA, make LEXER=dfa).
+// Классы символов, таблица переходов ДКА и совершенная хеш-функция ключевых слов
+// строятся на этапе компиляции, поэтому у Scanner нет затрат на инициализацию.
+// Лексемы и ошибки совпадают с ручным движком из scanner.cpp.
+#ifdef SCANNER_DFA
+
+#include "scanner.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+namespace {
+
+// --- Классы символов ---
+
+enum CharClass : uint8_t {
+    CC_OTHER,
+    CC_LETTER,    // a-z A-Z _ кроме букв ниже
+    CC_HEXLETTER, // a-f A-F
+    CC_X,         // x X
+    CC_ZERO,      // 0
+    CC_DIGIT,     // 1-9
+    CC_DOT,       // .
+    CC_QUOTE,     // '
+    CC_BACKSLASH, // обратная косая черта
+    CC_LPAREN, CC_RPAREN, CC_LBRACE, CC_RBRACE, CC_SEMICOLON, CC_COMMA,
+    CC_PLUS, CC_MINUS, CC_MUL, CC_DIV, CC_MOD, CC_BIT_OR, CC_BIT_AND, CC_BIT_XOR,
+    CC_ASSIGN,    // =
+    CC_BANG,      // !
+    CC_LESS,      // <
+    CC_GREATER,   // >
+    CC_EOF,       // Конец входа (в таблицу символов не попадает)
+    CC_COUNT
+};
+
+constexpr std::array<uint8_t, 256> makeCharClasses() {
+    std::array<uint8_t, 256> cls{};
+    for (int c = 'a'; c <= 'z'; ++c) cls[c] = CC_LETTER;
+    for (int c = 'A'; c <= 'Z'; ++c) cls[c] = CC_LETTER;
+    for (int c = 'a'; c <= 'f'; ++c) cls[c] = CC_HEXLETTER;
+    for (int c = 'A'; c <= 'F'; ++c) cls[c] = CC_HEXLETTER;
+    cls['_'] = CC_LETTER;
+    cls['x'] = CC_X;
+    cls['X'] = CC_X;
+    cls['0'] = CC_ZERO;
+    for (int c = '1'; c <= '9'; ++c) cls[c] = CC_DIGIT;
+    cls['.'] = CC_DOT;
+    cls['\''] = CC_QUOTE;
+    cls['\\'] = CC_BACKSLASH;
+    cls['('] = CC_LPAREN;
+    cls[')'] = CC_RPAREN;
+    cls['{'] = CC_LBRACE;
+    cls['}'] = CC_RBRACE;
+    cls[';'] = CC_SEMICOLON;
+    cls[','] = CC_COMMA;
+    cls['+'] = CC_PLUS;
+    cls['-'] = CC_MINUS;
+    cls['*'] = CC_MUL;
+    cls['/'] = CC_DIV;
+    cls['%'] = CC_MOD;
+    cls['|'] = CC_BIT_OR;
+    cls['&'] = CC_BIT_AND;
+    cls['^'] = CC_BIT_XOR;
+    cls['='] = CC_ASSIGN;
+    cls['!'] = CC_BANG;
+    cls['<'] = CC_LESS;
+    cls['>'] = CC_GREATER;
+    return cls;
+}
+
+constexpr std::array<uint8_t, 256> char_class = makeCharClasses();
+
+// Символы, которые могут стоять сразу после числа ('\0' - конец входа)
+constexpr std::array<bool, 256> makeNumberFollowers() {
+    std::array<bool, 256> ok{};
+    const char followers[] = " \t\n\r()[]{};,+-*/%<>=&|^";
+    for (size_t i = 0; followers[i] != '\0'; ++i) ok[static_cast<unsigned char>(followers[i])] = true;
+    ok[0] = true;
+    return ok;
+}
+
+constexpr std::array<bool, 256> number_follower = makeNumberFollowers();
+
+// --- Состояния ДКА ---
+// Переход в S_STOP означает "лексема закончилась, текущий символ не забираем";
+// тип лексемы берётся из accept[состояние]. Конечные состояния *_DONE из всех
+// классов переходят в S_STOP.
+
+enum State : uint8_t {
+    S_START,
+    S_IDENT,
+    S_ZERO, S_DEC, S_DOT, S_FRAC, S_HEX0, S_HEX,
+    S_CH0, S_CH_ESC, S_CH1, S_CH_DONE,
+    S_ASSIGN, S_BANG, S_LESS, S_GREATER,
+    S_LPAREN_DONE, S_RPAREN_DONE, S_LBRACE_DONE, S_RBRACE_DONE,
+    S_SEMICOLON_DONE, S_COMMA_DONE, S_PLUS_DONE, S_MINUS_DONE, S_MUL_DONE,
+    S_DIV_DONE, S_MOD_DONE, S_BIT_OR_DONE, S_BIT_AND_DONE, S_BIT_XOR_DONE,
+    S_EQ_DONE, S_NE_DONE, S_LE_DONE, S_LSHIFT_DONE, S_GE_DONE, S_RSHIFT_DONE,
+    S_ERROR_DONE,
+    S_COUNT,
+    S_STOP = S_COUNT
+};
+
+using TransitionTable = std::array<std::array<uint8_t, CC_COUNT>, S_COUNT>;
+
+constexpr void setRange(TransitionTable& t, State from, std::initializer_list<CharClass> classes, State to) {
+    for (CharClass cc : classes) t[from][cc] = to;
+}
+
+constexpr TransitionTable makeTransitions() {
+    TransitionTable t{};
+    for (auto& row : t)
+        for (auto& cell : row) cell = S_STOP;
+
+    const std::initializer_list<CharClass> letters = {CC_LETTER, CC_HEXLETTER, CC_X};
+    const std::initializer_list<CharClass> digits = {CC_ZERO, CC_DIGIT};
+    const std::initializer_list<CharClass> hex_digits = {CC_ZERO, CC_DIGIT, CC_HEXLETTER};
+
+    // Начальное состояние: всё, что не распознано, - ошибочный символ
+    for (int cc = 0; cc < CC_EOF; ++cc) t[S_START][cc] = S_ERROR_DONE;
+    setRange(t, S_START, letters, S_IDENT);
+    t[S_START][CC_ZERO] = S_ZERO;
+    t[S_START][CC_DIGIT] = S_DEC;
+    t[S_START][CC_DOT] = S_DOT;
+    t[S_START][CC_QUOTE] = S_CH0;
+    t[S_START][CC_LPAREN] = S_LPAREN_DONE;
+    t[S_START][CC_RPAREN] = S_RPAREN_DONE;
+    t[S_START][CC_LBRACE] = S_LBRACE_DONE;
+    t[S_START][CC_RBRACE] = S_RBRACE_DONE;
+    t[S_START][CC_SEMICOLON] = S_SEMICOLON_DONE;
+    t[S_START][CC_COMMA] = S_COMMA_DONE;
+    t[S_START][CC_PLUS] = S_PLUS_DONE;
+    t[S_START][CC_MINUS] = S_MINUS_DONE;
+    t[S_START][CC_MUL] = S_MUL_DONE;
+    t[S_START][CC_DIV] = S_DIV_DONE;
+    t[S_START][CC_MOD] = S_MOD_DONE;
+    t[S_START][CC_BIT_OR] = S_BIT_OR_DONE;
+    t[S_START][CC_BIT_AND] = S_BIT_AND_DONE;
+    t[S_START][CC_BIT_XOR] = S_BIT_XOR_DONE;
+    t[S_START][CC_ASSIGN] = S_ASSIGN;
+    t[S_START][CC_BANG] = S_BANG;
+    t[S_START][CC_LESS] = S_LESS;
+    t[S_START][CC_GREATER] = S_GREATER;
+
+    // Идентификаторы
+    setRange(t, S_IDENT, letters, S_IDENT);
+    setRange(t, S_IDENT, digits, S_IDENT);
+
+    // Числа
+    t[S_ZERO][CC_X] = S_HEX0;
+    setRange(t, S_ZERO, digits, S_DEC);
+    t[S_ZERO][CC_DOT] = S_FRAC;
+    setRange(t, S_DEC, digits, S_DEC);
+    t[S_DEC][CC_DOT] = S_FRAC;
+    setRange(t, S_DOT, digits, S_FRAC);
+    setRange(t, S_FRAC, digits, S_FRAC);
+    setRange(t, S_HEX0, hex_digits, S_HEX);
+    setRange(t, S_HEX, hex_digits, S_HEX);
+
+    // Символьные константы: ' [\] любой_символ '
+    for (int cc = 0; cc < CC_EOF; ++cc) {
+        t[S_CH0][cc] = S_CH1;
+        t[S_CH_ESC][cc] = S_CH1;
+    }
+    t[S_CH0][CC_BACKSLASH] = S_CH_ESC;
+    t[S_CH1][CC_QUOTE] = S_CH_DONE;
+
+    // Двухсимвольные операторы
+    t[S_ASSIGN][CC_ASSIGN] = S_EQ_DONE;
+    t[S_BANG][CC_ASSIGN] = S_NE_DONE;
+    t[S_LESS][CC_ASSIGN] = S_LE_DONE;
+    t[S_LESS][CC_LESS] = S_LSHIFT_DONE;
+    t[S_GREATER][CC_ASSIGN] = S_GE_DONE;
+    t[S_GREATER][CC_GREATER] = S_RSHIFT_DONE;
+    return t;
+}
+
+constexpr TransitionTable transitions = makeTransitions();
+
+constexpr std::array<uint8_t, S_COUNT> makeAccept() {
+    std::array<uint8_t, S_COUNT> a{};
+    for (auto& x : a) x = T_ERROR;
+    a[S_IDENT] = T_IDENT;
+    a[S_ZERO] = T_DEC_CONST;
+    a[S_DEC] = T_DEC_CONST;
+    a[S_FRAC] = T_FLOAT_CONST;
+    a[S_HEX] = T_HEX_CONST;
+    a[S_CH_DONE] = T_CHAR_CONST;
+    a[S_ASSIGN] = T_ASSIGN;
+    a[S_LESS] = T_LT;
+    a[S_GREATER] = T_GT;
+    a[S_LPAREN_DONE] = T_LPAREN;
+    a[S_RPAREN_DONE] = T_RPAREN;
+    a[S_LBRACE_DONE] = T_LBRACE;
+    a[S_RBRACE_DONE] = T_RBRACE;
+    a[S_SEMICOLON_DONE] = T_SEMICOLON;
+    a[S_COMMA_DONE] = T_COMMA;
+    a[S_PLUS_DONE] = T_PLUS;
+    a[S_MINUS_DONE] = T_MINUS;
+    a[S_MUL_DONE] = T_MUL;
+    a[S_DIV_DONE] = T_DIV;
+    a[S_MOD_DONE] = T_MOD;
+    a[S_BIT_OR_DONE] = T_BIT_OR;
+    a[S_BIT_AND_DONE] = T_BIT_AND;
+    a[S_BIT_XOR_DONE] = T_BIT_XOR;
+    a[S_EQ_DONE] = T_EQ;
+    a[S_NE_DONE] = T_NE;
+    a[S_LE_DONE] = T_LE;
+    a[S_LSHIFT_DONE] = T_LSHIFT;
+    a[S_GE_DONE] = T_GE;
+    a[S_RSHIFT_DONE] = T_RSHIFT;
+    return a;
+}
+
+constexpr std::array<uint8_t, S_COUNT> accept = makeAccept();
+
+// Текст операторов и разделителей
+constexpr std::array<const char*, T_ERROR + 1> makeSpelling() {
+    std::array<const char*, T_ERROR + 1> t{};
+    t[T_BIT_OR] = "|";  t[T_BIT_XOR] = "^"; t[T_BIT_AND] = "&";
+    t[T_EQ] = "==";     t[T_NE] = "!=";     t[T_LT] = "<";      t[T_LE] = "<=";
+    t[T_GT] = ">";      t[T_GE] = ">=";     t[T_LSHIFT] = "<<"; t[T_RSHIFT] = ">>";
+    t[T_PLUS] = "+";    t[T_MINUS] = "-";   t[T_MUL] = "*";     t[T_DIV] = "/";
+    t[T_MOD] = "%";     t[T_ASSIGN] = "=";
+    t[T_SEMICOLON] = ";"; t[T_COMMA] = ","; t[T_LPAREN] = "(";  t[T_RPAREN] = ")";
+    t[T_LBRACE] = "{";  t[T_RBRACE] = "}";
+    return t;
+}
+
+constexpr std::array<const char*, T_ERROR + 1> spelling = makeSpelling();
+
+// --- Совершенная хеш-функция ключевых слов ---
+// h = (первый_символ + 7 * последний_символ + длина) mod 16 не даёт коллизий
+// на восьми ключевых словах языка, что проверяется static_assert ниже.
+
+struct Keyword {
+    const char* text;
+    uint8_t length;
+    TokenType type;
+};
+
+constexpr Keyword keyword_list[] = {
+    {"void", 4, T_VOID}, {"short", 5, T_SHORT}, {"long", 4, T_LONG}, {"int", 3, T_INT},
+    {"double", 6, T_DOUBLE}, {"char", 4, T_CHAR}, {"while", 5, T_WHILE}, {"main", 4, T_MAIN},
+};
+
+constexpr size_t KEYWORD_TABLE_SIZE = 16;
+
+constexpr size_t keywordHash(char first, char last, size_t length) {
+    return (static_cast<unsigned char>(first) + 7u * static_cast<unsigned char>(last) + length) &
+           (KEYWORD_TABLE_SIZE - 1);
+}
+
+constexpr std::array<Keyword, KEYWORD_TABLE_SIZE> makeKeywordTable() {
+    std::array<Keyword, KEYWORD_TABLE_SIZE> table{};
+    for (auto& slot : table) slot = {"", 0, T_IDENT};
+    for (const Keyword& kw : keyword_list) {
+        table[keywordHash(kw.text[0], kw.text[kw.length - 1], kw.length)] = kw;
+    }
+    return table;
+}
+
+constexpr std::array<Keyword, KEYWORD_TABLE_SIZE> keyword_table = makeKeywordTable();
+
+constexpr bool keywordHashIsPerfect() {
+    for (const Keyword& kw : keyword_list) {
+        const Keyword& slot = keyword_table[keywordHash(kw.text[0], kw.text[kw.length - 1], kw.length)];
+        if (slot.type != kw.type) return false;
+    }
+    return true;
+}
+
+static_assert(keywordHashIsPerfect(), "Коллизия в хеш-функции ключевых слов");
+
+inline TokenType classifyWord(std::string_view text) {
+    const Keyword& kw = keyword_table[keywordHash(text.front(), text.back(), text.length())];
+    if (kw.length == text.length() && std::memcmp(kw.text, text.data(), text.length()) == 0) {
+        return kw.type;
+    }
+    return T_IDENT;
+}
+
+} // namespace
+
+// Таблица ключевых слов вычислена при компиляции - инициализировать нечего
+void Scanner::initEngine() {
+}
+
+// Основной метод: прогон ДКА по таблице переходов, значения констант и проверки окружения
+Token Scanner::lexToken() {
+    skipWhitespaceAndComments();
+
+    size_t start_pos = current_pos;
+    token_start = start_pos;
+    SourceLoc start_loc = locate(start_pos);
+
+    if (atEnd()) {
+        return {T_EOF, "EOF", start_loc};
+    }
+
+    // Символ вне ASCII во входе UTF-8 (он уже в окне - это проверил atEnd)
+    if (utf8 && static_cast<unsigned char>(source_code[current_pos - window_base]) >= 0x80) {
+        return lexNonAscii(start_pos, start_loc);
+    }
+
+    uint8_t state = S_START;
+    while (true) {
+        size_t rel = current_pos - window_base;
+        if (rel >= source_code.length() && refill()) rel = current_pos - window_base;
+        uint8_t cls = rel < source_code.length()
+                          ? char_class[static_cast<unsigned char>(source_code[rel])]
+                          : uint8_t(CC_EOF);
+        uint8_t next = transitions[state][cls];
+        if (next == S_STOP) break;
+        state = next;
+        current_pos++;
+    }
+
+    std::string_view text = textAt(start_pos, current_pos - start_pos);
+    TokenType type = static_cast<TokenType>(accept[state]);
+
+    switch (state) {
+        case S_IDENT:
+            if (utf8) {
+                // Идентификатор может продолжаться символами XID_Continue
+                current_pos = identEnd();
+                text = textAt(start_pos, current_pos - start_pos);
+            }
+            if (text.length() > MAX_LEX_LENGTH) {
+                return {T_ERROR, text, start_loc}; // Слишком длинный идентификатор
+            }
+            return {classifyWord(text), text, start_loc};
+
+        case S_CH_DONE: {
+            // Значение - по всей лексеме, текст - символ перед закрывающей кавычкой (без '\')
+            Token token = {T_CHAR_CONST, textAt(current_pos - 2, 1), start_loc};
+            decodeLiteral(token, text);
+            return token;
+        }
+
+        case S_CH0:
+        case S_CH_ESC:
+        case S_CH1:
+            return {T_ERROR, "Unclosed char literal", start_loc};
+
+        case S_ZERO:
+        case S_DEC:
+        case S_FRAC:
+        case S_HEX:
+            break;
+
+        default:
+            // Операторы получают статический текст: он переживает смену окна потока
+            if (spelling[type] != nullptr) return {type, spelling[type], start_loc};
+            return {type, text, start_loc};
+    }
+
+    // Значение константы и проверка диапазона ее типа
+    Token token = {type, text, start_loc};
+    if (!decodeLiteral(token, text)) {
+        return {T_ERROR, text, start_loc};
+    }
+
+    // Проверка на недопустимый символ после числа (он уже в окне - его смотрел ДКА)
+    size_t rel = current_pos - window_base;
+    unsigned char next_char = rel < source_code.length() ? source_code[rel] : 0;
+    if (!number_follower[next_char]) {
+        return {T_ERROR, textAt(start_pos, current_pos - start_pos + 1), start_loc};
+    }
+    return token;
+}
+
+#endif // SCANNER_DFA
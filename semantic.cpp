@@ -1,99 +1,353 @@
 #include "semantic.h"
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include "type_rules.h"
 
 // --- Реализация низкоуровневых функций ---
 
-SemanticAnalyzer::SemanticAnalyzer() {
-    root = new Symbol{"global", CAT_UNDEFINED, TYPE_UNDEFINED};
-    current_scope = root;
+namespace {
+
+const size_t INITIAL_BINDINGS = 256;
+
+// Метки глобальных узлов (Symbol::order) идут с шагом, чтобы вставка
+// описания в середину обычно не трогала меток соседей
+const uint32_t LABEL_STEP = 1u << 12;
+const uint32_t NO_HIDDEN = UINT32_MAX;  // Метки меньше: отрезанных узлов нет
+
+// Атомы выдаются подряд; умножение на 2^64/φ разносит соседние по таблице
+size_t bindingHash(Atom name) {
+    return static_cast<size_t>((name * 0x9E3779B97F4A7C15ull) >> 32);
 }
 
-SemanticAnalyzer::~SemanticAnalyzer() {
-    deleteSubtree(root);
+} // namespace
+
+SemanticAnalyzer::SemanticAnalyzer()
+    : free_symbols(nullptr), bindings(INITIAL_BINDINGS, Binding{ATOM_NONE, nullptr}), binding_count(0),
+      splicing(false), splice_tail(nullptr), splice_end(nullptr), hidden_from(NO_HIDDEN) {
+    root = newSymbol(atom_table.intern("global"), CAT_UNDEFINED, TYPE_UNDEFINED);
+    scopes.push_back({root, nullptr, 0});
+    source_map = nullptr;
+    diagnostics = nullptr;
+    global_lookups = nullptr;
+    globals = nullptr;
+    global_end = nullptr;
+    in_body = false;
 }
 
-void SemanticAnalyzer::enterScope() {
-    Symbol* new_scope_node = new Symbol{"scope", CAT_UNDEFINED, TYPE_UNDEFINED};
-    new_scope_node->parent = current_scope;
+void SemanticAnalyzer::setSourceMap(const SourceMap* map) {
+    source_map = map;
+}
 
-    // Ищем последнего ребенка в текущей области
-    if (current_scope->child == nullptr) {
-        current_scope->child = new_scope_node;
+void SemanticAnalyzer::setDiagnostics(DiagnosticSink* sink) {
+    diagnostics = sink;
+}
+
+void SemanticAnalyzer::error(SourceLoc loc, const std::string& message) {
+    diagnostics->error(loc, "Ошибка на ", ": " + message);
+}
+
+// --- Память символов ---
+
+Symbol* SemanticAnalyzer::newSymbol(Atom name, ObjectCategory category, DataType type) {
+    Symbol* sym = free_symbols;
+    if (sym != nullptr) {
+        free_symbols = sym->next;
     } else {
-        Symbol* temp = current_scope->child;
-        while (temp->next != nullptr) {
-            temp = temp->next;
+        sym = storage.symbols.at(storage.symbols.allocate());
+    }
+    *sym = Symbol{name, category, type};
+    return sym;
+}
+
+void SemanticAnalyzer::freeSymbol(Symbol* sym) {
+    if (sym == nullptr) return;
+    sym->next = free_symbols;
+    free_symbols = sym;
+}
+
+const Param* SemanticAnalyzer::newParams(const std::vector<Param>& params) {
+    if (params.empty()) return nullptr;
+    Param* slice = storage.params.at(storage.params.allocate(params.size()));
+    std::copy(params.begin(), params.end(), slice);
+    return slice;
+}
+
+// Блоки арен не перемещаются, поэтому символы other остаются на своих
+// адресах; other начинает с пустых арен
+void SemanticAnalyzer::adoptSymbols(SemanticAnalyzer& other) {
+    adopted.push_back(std::move(other.storage));
+    other.storage = Storage();
+    other.free_symbols = nullptr;
+}
+
+// Отрезанный глобальный узел (detachGlobalsAfter) не виден
+Symbol* SemanticAnalyzer::lookup(Atom name) const {
+    size_t mask = bindings.size() - 1;
+    for (size_t i = bindingHash(name) & mask; bindings[i].name != ATOM_NONE; i = (i + 1) & mask) {
+        if (bindings[i].name != name) continue;
+        Symbol* sym = bindings[i].symbol;
+        if (sym != nullptr && sym->order >= hidden_from && sym->parent == root) return nullptr;
+        return sym;
+    }
+    return nullptr;
+}
+
+// Имена из таблицы не удаляются (у невидимого имени symbol == nullptr),
+// поэтому заполненность ограничена числом разных имён
+SemanticAnalyzer::Binding& SemanticAnalyzer::claim(Atom name) {
+    if ((binding_count + 1) * 2 > bindings.size()) grow(); // Заполненность не больше половины
+    size_t mask = bindings.size() - 1;
+    size_t i = bindingHash(name) & mask;
+    while (bindings[i].name != name && bindings[i].name != ATOM_NONE) i = (i + 1) & mask;
+    if (bindings[i].name == ATOM_NONE) {
+        bindings[i].name = name;
+        binding_count++;
+    }
+    return bindings[i];
+}
+
+void SemanticAnalyzer::grow() {
+    std::vector<Binding> bigger(bindings.size() * 2, Binding{ATOM_NONE, nullptr});
+    size_t mask = bigger.size() - 1;
+    for (const Binding& b : bindings) {
+        if (b.name == ATOM_NONE) continue;
+        size_t i = bindingHash(b.name) & mask;
+        while (bigger[i].name != ATOM_NONE) i = (i + 1) & mask;
+        bigger[i] = b;
+    }
+    bindings.swap(bigger);
+}
+
+void SemanticAnalyzer::bind(Symbol* sym) {
+    Binding& b = claim(sym->name);
+    // Глобальная область не закрывается, её символам журнал не нужен
+    if (scopes.size() > 1) shadowed.push_back({sym->name, b.symbol});
+    b.symbol = sym;
+}
+
+// Новый глобальный узел получает метку больше меток прежних; пока часть
+// области отрезана, метка временная (ниже отрезанных), настоящие метки
+// ставит appendGlobals
+void SemanticAnalyzer::appendChild(Symbol* node) {
+    OpenScope& scope = scopes.back();
+    node->parent = scope.node;
+    if (scope.node == root) {
+        if (splicing) {
+            node->order = splice_tail != nullptr ? splice_tail->order : 0;
+        } else if (scope.last_child == nullptr) {
+            node->order = LABEL_STEP;
+        } else if (scope.last_child->order < NO_HIDDEN - LABEL_STEP) {
+            node->order = scope.last_child->order + LABEL_STEP;
+        } else {
+            relabelAllGlobals();
+            node->order = scope.last_child->order + LABEL_STEP;
         }
-        temp->next = new_scope_node;
     }
-    current_scope = new_scope_node;
+    if (scope.last_child == nullptr) {
+        scope.node->child = node;
+    } else {
+        scope.last_child->next = node;
+    }
+    scope.last_child = node;
+}
+
+void SemanticAnalyzer::enterScope() {
+    Symbol* new_scope_node = newSymbol(ATOM_NONE, CAT_UNDEFINED, TYPE_UNDEFINED);
+    appendChild(new_scope_node);
+    scopes.push_back({new_scope_node, nullptr, shadowed.size()});
 }
 
 void SemanticAnalyzer::leaveScope() {
-    if (current_scope->parent != nullptr) {
-        current_scope = current_scope->parent;
+    if (scopes.size() == 1) return;
+    // Имена области снова означают то, что до неё
+    size_t mark = scopes.back().shadow_mark;
+    while (shadowed.size() > mark) {
+        claim(shadowed.back().name).symbol = shadowed.back().previous;
+        shadowed.pop_back();
     }
+    scopes.pop_back();
 }
 
 bool SemanticAnalyzer::addSymbol(Symbol* sym) {
     if (findSymbolInCurrentScope(sym->name) != nullptr) {
         return false; // Символ уже существует в этой области
     }
-    
-    sym->parent = current_scope;
+    appendChild(sym);
+    bind(sym);
+    return true;
+}
+
+// Самый внутренний символ имени объявлен в текущей области, если он там есть
+Symbol* SemanticAnalyzer::findSymbolInCurrentScope(Atom name) {
+    if (global_lookups != nullptr && scopes.size() == 1) global_lookups->push_back(name);
+    Symbol* sym = lookup(name);
+    return sym != nullptr && sym->parent == scopes.back().node ? sym : nullptr;
+}
+
+Symbol* SemanticAnalyzer::findSymbol(Atom name) {
+    Symbol* sym = lookup(name);
+    if (sym == nullptr && globals != nullptr) sym = globals->findGlobalBefore(name, global_end);
+    // Поиск дошёл до глобальной области
+    if (global_lookups != nullptr && (sym == nullptr || sym->parent == root)) global_lookups->push_back(name);
+    return sym;
+}
+
+// Только чтение: тела функций ищут здесь из нескольких потоков
+Symbol* SemanticAnalyzer::findGlobalBefore(Atom name, const Symbol* end) const {
+    Symbol* sym = lookup(name);
+    if (sym == nullptr || sym->parent != root || sym->order > end->order) return nullptr;
+    return sym;
+}
+
+
+Symbol* SemanticAnalyzer::nextGlobal(Symbol* after) {
+    return after != nullptr ? after->next : root->child;
+}
+
+Symbol* SemanticAnalyzer::lastGlobal(Symbol* from) {
+    Symbol* last = from != nullptr ? from : root->child;
+    while (last != nullptr && last->next != nullptr) last = last->next;
+    return last;
+}
 
-    // Добавляем в список дочерних узлов текущей области
-    if (current_scope->child == nullptr) {
-        current_scope->child = sym;
+// Отрезанные узлы не видны по меткам (hidden_from), поэтому таблица имён
+// не перестраивается и отрезание - O(1). Метки отрезанных больше метки last,
+// а новые узлы до appendGlobals получают метку last.
+Symbol* SemanticAnalyzer::detachGlobalsAfter(Symbol* last) {
+    while (scopes.size() > 1) leaveScope(); // Журнал не должен ссылаться на отрезанное
+    Symbol* chain;
+    if (last == nullptr) {
+        chain = root->child;
+        root->child = nullptr;
     } else {
-        Symbol* temp = current_scope->child;
-        while (temp->next != nullptr) {
-            temp = temp->next;
-        }
-        temp->next = sym;
+        chain = last->next;
+        last->next = nullptr;
     }
-    return true;
+    splicing = true;
+    splice_tail = last;
+    splice_end = chain != nullptr ? scopes[0].last_child : nullptr;
+    hidden_from = chain != nullptr ? chain->order : NO_HIDDEN;
+    scopes[0].last_child = last;
+    return chain;
 }
 
-Symbol* SemanticAnalyzer::findSymbolInCurrentScope(const std::string& name) {
-    for (Symbol* current = current_scope->child; current != nullptr; current = current->next) {
-        if (current->name == name) {
-            return current;
+// Имя, объявленное новыми узлами, уже связано с ними: они стоят в цепочке
+// раньше chain. Обход - только по новым узлам.
+void SemanticAnalyzer::appendGlobals(Symbol* chain) {
+    while (scopes.size() > 1) leaveScope();
+    Symbol* last = scopes[0].last_child;
+    if (chain != nullptr) {
+        if (last == nullptr) {
+            root->child = chain;
+        } else {
+            last->next = chain;
         }
+        scopes[0].last_child = splice_end;
     }
-    return nullptr;
+    splicing = false;
+    hidden_from = NO_HIDDEN;
+    if (last != splice_tail) relabelGlobals(splice_tail, chain);
 }
 
-Symbol* SemanticAnalyzer::findSymbol(const std::string& name) {
-    for (Symbol* scope = current_scope; scope != nullptr; scope = scope->parent) {
-        for (Symbol* current = scope->child; current != nullptr; current = current->next) {
-            if (current->name == name) {
-                return current;
-            }
+// Новые узлы после after (nullptr - с начала) до before (nullptr - до конца)
+// получают метки поровну между соседями; не хватает места - все узлы заново
+void SemanticAnalyzer::relabelGlobals(Symbol* after, Symbol* before) {
+    uint32_t low = after != nullptr ? after->order : 0;
+    uint64_t high = before != nullptr ? before->order : NO_HIDDEN;
+    Symbol* first = after != nullptr ? after->next : root->child;
+    uint64_t count = 0;
+    for (Symbol* sym = first; sym != before; sym = sym->next) count++;
+    uint64_t step = (high - low) / (count + 1);
+    if (before == nullptr && step > LABEL_STEP) step = LABEL_STEP;
+    if (step == 0) {
+        relabelAllGlobals();
+        return;
+    }
+    uint64_t label = low;
+    for (Symbol* sym = first; sym != before; sym = sym->next) {
+        label += step;
+        sym->order = static_cast<uint32_t>(label);
+    }
+}
+
+void SemanticAnalyzer::relabelAllGlobals() {
+    uint64_t count = 0;
+    for (Symbol* sym = root->child; sym != nullptr; sym = sym->next) count++;
+    uint64_t step = std::min<uint64_t>(LABEL_STEP, (NO_HIDDEN - 1) / (count + 1));
+    if (step == 0) throw std::runtime_error("Слишком много описаний в глобальной области.");
+    uint64_t label = 0;
+    for (Symbol* sym = root->child; sym != nullptr; sym = sym->next) {
+        label += step;
+        sym->order = static_cast<uint32_t>(label);
+    }
+}
+
+// Обход с явным стеком: цепочки next (все символы области) и вложенность
+// областей могут быть сколь угодно длинными. Параметры функций остаются в
+// арене до конца работы анализатора.
+void SemanticAnalyzer::deleteSymbols(Symbol* chain) {
+    std::vector<Symbol*> pending;
+    if (chain != nullptr) pending.push_back(chain);
+    while (!pending.empty()) {
+        Symbol* node = pending.back();
+        pending.pop_back();
+        if (node->child != nullptr) pending.push_back(node->child);
+        if (node->next != nullptr) pending.push_back(node->next);
+        if (node->parent == root && node->name != ATOM_NONE) {
+            Binding& b = claim(node->name);
+            if (b.symbol == node) b.symbol = nullptr;
         }
+        freeSymbol(node);
     }
-    return nullptr;
 }
 
+void SemanticAnalyzer::setGlobalLookupLog(std::vector<Atom>* log) {
+    global_lookups = log;
+}
 
-// --- Реализация вспомогательных функций ---
+// Параметры и уже объявленные символы области scope видны через свою
+// таблицу, глобальные символы - через таблицу globals
+void SemanticAnalyzer::enterBody(const SemanticAnalyzer* global_analyzer, Symbol* scope) {
+    while (scopes.size() > 1) leaveScope();
+    globals = global_analyzer;
+    global_end = scope;
+    in_body = true;
+    assigned_globals.clear();
+    scopes.push_back({scope, nullptr, shadowed.size()});
+    for (Symbol* sym = scope->child; sym != nullptr; sym = sym->next) {
+        if (sym->name != ATOM_NONE) bind(sym);
+        scopes.back().last_child = sym;
+    }
+}
 
-void SemanticAnalyzer::deleteSubtree(Symbol* node) {
-    if (node == nullptr) return;
-    deleteSubtree(node->child);
-    deleteSubtree(node->next);
-    // Дополнительная очистка памяти для параметров функции
-    if(node->category == CAT_FUNCTION) {
-        Param* p = node->func_info.params;
-        while(p) {
-            Param* next = p->next;
-            delete p;
-            p = next;
-        }
+const std::unordered_set<Atom>& SemanticAnalyzer::getAssignedGlobals() const {
+    return assigned_globals;
+}
+
+void SemanticAnalyzer::markInitialized(Symbol* var) {
+    if (in_body && isGlobal(var)) {
+        assigned_globals.insert(var->name);
+    } else {
+        var->var_info.is_initialized = true;
     }
-    delete node;
 }
 
+Symbol* SemanticAnalyzer::getCurrentScope() const {
+    return scopes.back().node;
+}
+
+bool SemanticAnalyzer::isInitialized(const Symbol* var) const {
+    if (var->var_info.is_initialized) return true;
+    return in_body && isGlobal(var) && assigned_globals.count(var->name) != 0;
+}
+
+bool SemanticAnalyzer::isGlobal(const Symbol* sym) {
+    return sym->parent != nullptr && sym->parent->parent == nullptr;
+}
+
+// --- Реализация вспомогательных функций ---
+
 void SemanticAnalyzer::printTree() {
     std::cout << "\n--- Semantic Tree ---\n";
     printSubtree(root, 0);
@@ -101,18 +355,28 @@ void SemanticAnalyzer::printTree() {
 }
 
 void SemanticAnalyzer::printSubtree(Symbol* node, int depth) {
-    if (node == nullptr) return;
+    // Узел печатается раньше своих детей, дети - раньше следующих соседей
+    std::vector<std::pair<Symbol*, int>> pending;
+    if (node != nullptr) pending.push_back({node, depth});
+    while (!pending.empty()) {
+        node = pending.back().first;
+        depth = pending.back().second;
+        pending.pop_back();
+        if (node->next != nullptr) pending.push_back({node->next, depth});
+        if (node->child != nullptr) pending.push_back({node->child, depth + 1});
 
-    for (int i = 0; i < depth; ++i) std::cout << "  ";
+        for (int i = 0; i < depth; ++i) std::cout << "  ";
 
-    if (node->name == "scope") {
-        std::cout << "[Scope]\n";
-    } else {
-        std::cout << node->name << " (" << dataTypeToString(node->type) << ")\n";
+        if (node->name == ATOM_NONE) {
+            std::cout << "[Scope]\n";
+        } else {
+            std::cout << atom_table.name(node->name) << " (" << dataTypeToString(node->type) << ")\n";
+        }
     }
+}
 
-    printSubtree(node->child, depth + 1);
-    printSubtree(node->next, depth);
+std::string SemanticAnalyzer::symbolName(Atom name) {
+    return std::string(atom_table.name(name));
 }
 
 std::string SemanticAnalyzer::dataTypeToString(DataType type) {
@@ -142,68 +406,35 @@ DataType SemanticAnalyzer::tokenTypeToDataType(TokenType type) {
 // --- Реализация высокоуровневых функций ---
 
 // Проверка операции присваивания
-void SemanticAnalyzer::semCheckAssignment(Symbol* left, DataType right_type, int line) {
+void SemanticAnalyzer::semCheckAssignment(Symbol* left, DataType right_type, SourceLoc loc) {
     if (left->category != CAT_VARIABLE && left->category != CAT_PARAMETER) {
-        throw std::runtime_error("Ошибка на строке " + std::to_string(line) + ": Нельзя присвоить значение не-переменной '" + left->name + "'");
-    }
-
-    DataType left_type = left->type;
-
-    if (left_type == right_type) {
-        return;
-    }
-
-    bool is_right_int_family = (right_type == TYPE_INT || right_type == TYPE_SHORT || right_type == TYPE_LONG || right_type == TYPE_CHAR);
-    if (left_type == TYPE_DOUBLE && is_right_int_family) {
+        error(loc, "Нельзя присвоить значение не-переменной '" + symbolName(left->name) + "'");
         return;
     }
 
-    bool is_left_int_family = (left_type == TYPE_INT || left_type == TYPE_SHORT || left_type == TYPE_LONG || left_type == TYPE_CHAR);
-    if (is_left_int_family && right_type == TYPE_DOUBLE) {
-        std::cout << "[Warning]: На строке " << line
-                  << ": возможно сужающее преобразование (потеря данных) при присваивании '"
-                  << dataTypeToString(right_type) << "' переменной типа '"
-                  << dataTypeToString(left_type) << "'." << std::endl;
-        return;
+    DataType left_type = left->type;
+    switch (conversions[SITE_ASSIGN][left_type][right_type]) {
+        case CONV_OK:
+            break;
+        case CONV_NARROWING:
+            diagnostics->warning(*source_map, loc, "[Warning]: На ",
+                                 ": возможно сужающее преобразование (потеря данных) при присваивании '" +
+                                 dataTypeToString(right_type) + "' переменной типа '" +
+                                 dataTypeToString(left_type) + "'.");
+            break;
+        case CONV_INCOMPATIBLE:
+            error(loc, "Несовместимые типы при присваивании. Нельзя присвоить '" + dataTypeToString(right_type) + "' переменной типа '" + dataTypeToString(left_type) + "'");
+            break;
     }
-
-    // Ошибка при несовместимости типов
-    throw std::runtime_error("Ошибка на строке " + std::to_string(line) + ": Несовместимые типы при присваивании. Нельзя присвоить '" + dataTypeToString(right_type) + "' переменной типа '" + dataTypeToString(left_type) + "'");
 }
 
 // Проверка типов в бинарной операции
-DataType SemanticAnalyzer::semCheckBinaryExpr(DataType left_type, const Token& op, DataType right_type, int line) {
-    bool is_left_int_family = (left_type == TYPE_INT || left_type == TYPE_SHORT || left_type == TYPE_LONG || left_type == TYPE_CHAR);
-    bool is_right_int_family = (right_type == TYPE_INT || right_type == TYPE_SHORT || right_type == TYPE_LONG || right_type == TYPE_CHAR);
-
-    switch (op.type) {
-        // Арифметические операции
-        case T_PLUS: case T_MINUS: case T_MUL: case T_DIV:
-            if (left_type == TYPE_DOUBLE || right_type == TYPE_DOUBLE) return TYPE_DOUBLE;
-            if (is_left_int_family && is_right_int_family) return TYPE_INT; // Упрощенно, возвращаем INT для всех целых
-            break;
+DataType SemanticAnalyzer::semCheckBinaryExpr(DataType left_type, const Token& op, DataType right_type, SourceLoc loc) {
+    // TYPE_UNDEFINED без ошибки - об ошибке в операнде уже сообщено
+    BinaryRule rule = binary_rules[op.type][left_type][right_type];
+    if (!rule.error) return static_cast<DataType>(rule.result);
 
-        case T_MOD:
-            if (is_left_int_family && is_right_int_family) return TYPE_INT;
-            break;
-            
-        // Побитовые операции
-        case T_BIT_OR: case T_BIT_XOR: case T_BIT_AND: case T_LSHIFT: case T_RSHIFT:
-            if (is_left_int_family && is_right_int_family) return TYPE_INT;
-            break;
-            
-        // Операции сравнения
-        case T_EQ: case T_NE: case T_LT: case T_LE: case T_GT: case T_GE:
-            // Сравнивать можно любые числовые типы и char между собой
-            if ((is_left_int_family || left_type == TYPE_DOUBLE) && (is_right_int_family || right_type == TYPE_DOUBLE)) {
-                return TYPE_INT; // Результат сравнения - логический (int)
-            }
-            break;
-        
-        default:
-            break;
-    }
-    
     // Если ни одно правило не подошло, это ошибка
-    throw std::runtime_error("Ошибка на строке " + std::to_string(line) + ": Операция '" + op.text + "' не применима к операндам типов '" + dataTypeToString(left_type) + "' и '" + dataTypeToString(right_type) + "'");
+    error(loc, "Операция '" + std::string(op.text) + "' не применима к операндам типов '" + dataTypeToString(left_type) + "' и '" + dataTypeToString(right_type) + "'");
+    return TYPE_UNDEFINED;
 }
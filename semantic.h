@@ -2,8 +2,14 @@
 #define SEMANTIC_H
 
 #include <string>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
+#include "arena.h"
 #include "scanner.h"
+#include "location.h"
+#include "intern.h"
+#include "diagnostics.h"
 
 // Перечисление категорий объектов
 enum ObjectCategory {
@@ -27,27 +33,31 @@ enum DataType {
 // Предварительное объявление структуры Symbol
 struct Symbol;
 
-// Структура для описания одного параметра функции
+// Структура для описания одного параметра функции. Параметры функции
+// лежат подряд в арене анализатора (SemanticAnalyzer::newParams)
 struct Param {
-    std::string name;
+    Atom name;
     DataType type;
-    Param* next = nullptr;
 };
 
 // Структура узла семантического дерева (Symbol)
+// Имена - атомы из atom_table; у узлов областей видимости имени нет (ATOM_NONE)
 struct Symbol {
-    std::string name;
+    Atom name;
     ObjectCategory category;
     DataType type;
+    uint32_t order = 0;  // Метка места в глобальной области: растёт вдоль цепочки (у вложенных - 0)
     
     union {
         struct {
-            Param* params;
+            const Param* params; // Срез из param_count параметров
             int param_count;
+            uint32_t code;       // Номер в Bytecode::functions (см. CodeEmitter)
         } func_info;
         
         struct {
             bool is_initialized;
+            uint32_t slot;       // Ячейка в байт-коде (см. CodeEmitter)
         } var_info;
     };
 
@@ -56,36 +66,141 @@ struct Symbol {
     Symbol* next = nullptr;
 };
 
-// Класс семантического анализатора
+// Класс семантического анализатора.
+// Поиск имён не ходит по дереву: видимые имена лежат в хеш-таблице с
+// открытой адресацией по атому, где для каждого имени - самый внутренний
+// видимый символ. Объявление во вложенной области запоминает в журнале
+// затенения прежний символ имени, а закрытие области возвращает прежние
+// символы из своего отрезка журнала. Поиск и добавление - O(1), закрытие
+// области - O(1) на объявленный в ней символ. Дерево по-прежнему владеет
+// символами и служит видом для printTree и цепочки глобальной области.
+//
+// Символы и параметры выделяются из арен анализатора (BumpArena) и
+// освобождаются все разом вместе с ним, без обхода дерева.
 class SemanticAnalyzer {
 public:
     SemanticAnalyzer();
-    ~SemanticAnalyzer();
+
+    // --- Память символов ---
+    Symbol* newSymbol(Atom name, ObjectCategory category, DataType type);
+    void freeSymbol(Symbol* sym);  // Символ, не попавший в дерево (nullptr - ничего)
+    const Param* newParams(const std::vector<Param>& params); // Срез-копия; nullptr - пусто
+    // Забрать память символов other: его символы связаны с этим деревом
+    // (тела функций, разобранные в других потоках)
+    void adoptSymbols(SemanticAnalyzer& other);
 
     // Низкоуровневые функции
     void enterScope();
     void leaveScope();
     bool addSymbol(Symbol* sym);
-    Symbol* findSymbol(const std::string& name);
-    Symbol* findSymbolInCurrentScope(const std::string& name);
+    Symbol* findSymbol(Atom name);
+    Symbol* findSymbolInCurrentScope(Atom name);
+
+    // Высокоуровневые функции. Ошибки сообщаются в приёмник диагностики;
+    // тип TYPE_UNDEFINED означает операнд, в котором уже найдена ошибка,
+    // и повторно о нём не сообщается.
+    void semCheckAssignment(Symbol* left, DataType right_type, SourceLoc loc);
+    DataType semCheckBinaryExpr(DataType left_type, const Token& op, DataType right_type, SourceLoc loc);
+
+    // --- Глобальная область по частям (инкрементальный разбор) ---
+    // Узлы глобальной области (символы и области функций) - цепочка в порядке
+    // описаний; каждое описание верхнего уровня владеет отрезком цепочки.
+    Symbol* nextGlobal(Symbol* after);         // Узел после after (nullptr - первый узел)
+    Symbol* lastGlobal(Symbol* from);          // Последний узел цепочки, начиная с from (nullptr - с начала)
+    // Отрезать узлы после last (nullptr - все) и вернуть отрезанные. Имена
+    // отрезанных остаются в таблице, но не видны; новые узлы встают после last.
+    Symbol* detachGlobalsAfter(Symbol* last);
+    // Вернуть на место конец chain отрезанной цепочки (nullptr - ничего);
+    // остальное отрезанное к этому времени удалено (deleteSymbols)
+    void appendGlobals(Symbol* chain);
+    void deleteSymbols(Symbol* chain);         // Освободить цепочку вместе с вложенными областями
+    // Журнал имён, искавшихся в глобальной области (найденных там или не
+    // найденных вовсе); nullptr - не вести
+    void setGlobalLookupLog(std::vector<Atom>* log);
 
-    // Высокоуровневые функции
-    void semCheckAssignment(Symbol* left, DataType right_type, int line);
-    DataType semCheckBinaryExpr(DataType left_type, const Token& op, DataType right_type, int line);
+    // --- Тело функции в отдельном потоке (ParallelParser) ---
+    // Текущая область - scope, область функции в дереве анализатора globals
+    // (глобальная область достижима из неё по parent). Глобальная
+    // область только читается и видна до scope включительно, как при
+    // последовательном разборе. Присваивания глобальным переменным не
+    // меняют их символы, а запоминаются здесь (getAssignedGlobals).
+    void enterBody(const SemanticAnalyzer* globals, Symbol* scope);
+    const std::unordered_set<Atom>& getAssignedGlobals() const;
+    Symbol* getCurrentScope() const;
+
+    // Инициализация переменных (для предупреждений)
+    void markInitialized(Symbol* var);
+    bool isInitialized(const Symbol* var) const;
+    static bool isGlobal(const Symbol* sym);
+
+    // Источник строк и столбцов для сообщений об ошибках
+    void setSourceMap(const SourceMap* map);
+    // Куда сообщать об ошибках
+    void setDiagnostics(DiagnosticSink* sink);
     
     // Функция для вывода дерева в консоль
     void printTree();
+    // Текст имени символа для сообщений
+    static std::string symbolName(Atom name);
     // Функция для преобразования DataType в строку
     static std::string dataTypeToString(DataType type);
     // Функция для преобразования TokenType в DataType
     static DataType tokenTypeToDataType(TokenType type);
 
 private:
+    struct Storage {
+        BumpArena<Symbol, 12> symbols;
+        BumpArena<Param, 12> params;
+    };
+    struct Binding {       // Ячейка хеш-таблицы видимых имён
+        Atom name;         // ATOM_NONE - ячейка свободна
+        Symbol* symbol;    // Самый внутренний видимый символ (nullptr - имя не видно)
+    };
+    struct OpenScope {
+        Symbol* node;
+        Symbol* last_child;  // Для добавления в конец списка детей за O(1)
+        size_t shadow_mark;  // Начало записей области в журнале затенения
+    };
+    struct Shadowed {      // Символ имени до объявления во вложенной области
+        Atom name;
+        Symbol* previous;
+    };
+
+    Storage storage;
+    std::vector<Storage> adopted;    // Память других анализаторов (adoptSymbols)
+    Symbol* free_symbols;  // Освобождённые символы, связанные через next
     Symbol* root;          // Корень всего дерева
-    Symbol* current_scope; // Указатель на текущую область видимости
+    std::vector<OpenScope> scopes;   // Открытые области; scopes[0] - глобальная
+    std::vector<Binding> bindings;   // Размер - степень двойки
+    size_t binding_count;
+    std::vector<Shadowed> shadowed;  // Журнал затенения вложенных областей
+    // Отрезанная часть глобальной области (detachGlobalsAfter - appendGlobals)
+    bool splicing;
+    Symbol* splice_tail;   // Узел, после которого встают новые
+    Symbol* splice_end;    // Последний узел отрезанной цепочки
+    uint32_t hidden_from;  // Глобальные узлы с меткой не меньше не видны
+    const SourceMap* source_map;
+    DiagnosticSink* diagnostics;
+    std::vector<Atom>* global_lookups;
+    const SemanticAnalyzer* globals; // Анализатор с глобальной областью тела (enterBody)
+    Symbol* global_end;    // Последний видимый узел глобальной области (nullptr - вся)
+    bool in_body;          // Проверяется тело функции из другого дерева (enterBody)
+    std::unordered_set<Atom> assigned_globals;
+
+    void error(SourceLoc loc, const std::string& message);
+
+    // --- Таблица видимых имён ---
+    Symbol* lookup(Atom name) const;
+    Binding& claim(Atom name);       // Ячейка имени; новое имя занимает свободную
+    void bind(Symbol* sym);          // Сделать sym видимым в текущей области
+    void grow();
+    void appendChild(Symbol* node);  // Узел в конец текущей области дерева
+    void relabelGlobals(Symbol* after, Symbol* before); // Метки узлов между after и before
+    void relabelAllGlobals();
+    // Глобальный символ, видимый в теле функции с областью end
+    Symbol* findGlobalBefore(Atom name, const Symbol* end) const;
 
-    // Рекурсивные вспомогательные функции
-    void deleteSubtree(Symbol* node);
+    // Обход поддерева (без рекурсии)
     void printSubtree(Symbol* node, int depth);
 };
 
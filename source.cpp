@@ -0,0 +1,113 @@
+#include "source.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SourceFile::SourceFile() : data(nullptr), size(0), opened(false) {
+#ifdef _WIN32
+    file_handle = INVALID_HANDLE_VALUE;
+    mapping_handle = nullptr;
+#endif
+}
+
+SourceFile::~SourceFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool SourceFile::open(const char* path) {
+    close();
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+    file_handle = file;
+    opened = true;
+    size = static_cast<size_t>(file_size.QuadPart);
+    if (size == 0) return true; // Пустой файл отобразить нельзя, но он корректен
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        close();
+        return false;
+    }
+    mapping_handle = mapping;
+    data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data == nullptr) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SourceFile::close() {
+    if (data != nullptr) UnmapViewOfFile(data);
+    if (mapping_handle != nullptr) CloseHandle(mapping_handle);
+    if (file_handle != INVALID_HANDLE_VALUE) CloseHandle(file_handle);
+    file_handle = INVALID_HANDLE_VALUE;
+    mapping_handle = nullptr;
+    data = nullptr;
+    size = 0;
+    opened = false;
+}
+
+#else
+
+bool SourceFile::open(const char* path) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    size = static_cast<size_t>(st.st_size);
+    opened = true;
+    if (size == 0) { // Пустой файл отобразить нельзя, но он корректен
+        ::close(fd);
+        return true;
+    }
+
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // Отображение остаётся действительным и без дескриптора
+    if (mapped == MAP_FAILED) {
+        size = 0;
+        opened = false;
+        return false;
+    }
+    // Файл читается строго последовательно
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    data = static_cast<const char*>(mapped);
+    return true;
+}
+
+void SourceFile::close() {
+    if (data != nullptr) munmap(const_cast<char*>(data), size);
+    data = nullptr;
+    size = 0;
+    opened = false;
+}
+
+#endif
+
+bool SourceFile::is_open() const {
+    return opened;
+}
+
+std::string_view SourceFile::text() const {
+    return std::string_view(data, size);
+}
@@ -0,0 +1,36 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <cstddef>
+#include <string_view>
+
+// Исходный файл, отображённый в память только для чтения.
+// Сканер получает std::string_view на отображение, поэтому текст
+// программы не копируется ни при чтении, ни при разборе лексем.
+class SourceFile {
+public:
+    SourceFile();
+    ~SourceFile();
+
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    // Открыть и отобразить файл; false, если файл недоступен
+    bool open(const char* path);
+    bool is_open() const;
+    void close();
+
+    // Весь текст файла (действителен, пока объект не закрыт)
+    std::string_view text() const;
+
+private:
+    const char* data;
+    size_t size;
+    bool opened;
+#ifdef _WIN32
+    void* file_handle;
+    void* mapping_handle;
+#endif
+};
+
+#endif // SOURCE_H
@@ -0,0 +1,215 @@
+#include "token_buffer.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Лексемы одного куска входа при параллельном разборе
+struct TokenChunk {
+    size_t begin;       // Предполагаемая точка перезапуска (начало строки)
+    size_t end;         // Граница: лексемы, начинающиеся дальше, принадлежат следующему куску
+    std::vector<uint8_t> types;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> lengths;
+    size_t next_start;  // Начало первой лексемы за границей
+    size_t resume_pos;  // Позиция сканера перед этой лексемой
+};
+
+// Лексема, только что выданная сканером, в виде (тип, смещение, длина)
+void appendToken(TokenChunk& chunk, Scanner& scanner, const Token& tok, const char* begin) {
+    size_t start = scanner.getTokenStart();
+    size_t len = scanner.getUK() - start;
+    // Ошибка "число + недопустимый символ" захватывает символ за лексемой
+    if (tok.type == T_ERROR && tok.text.data() == begin + start) {
+        len = tok.text.length();
+    }
+    chunk.types.push_back(static_cast<uint8_t>(tok.type));
+    chunk.offsets.push_back(static_cast<uint32_t>(start));
+    chunk.lengths.push_back(static_cast<uint32_t>(len));
+}
+
+// Разбор куска: от chunk.begin до первой лексемы, начинающейся на chunk.end или дальше
+void lexChunk(std::string_view source, bool utf8, TokenChunk& chunk) {
+    size_t estimate = (std::min(chunk.end, source.length()) - std::min(chunk.begin, source.length())) / 4 + 1;
+    chunk.types.reserve(estimate);
+    chunk.offsets.reserve(estimate);
+    chunk.lengths.reserve(estimate);
+
+    Scanner scanner(source, nullptr, utf8); // Потоки не трогают общую таблицу атомов
+    scanner.putUK(chunk.begin);
+    while (true) {
+        size_t resume = scanner.getUK();
+        Token tok = scanner.getNextToken();
+        if (scanner.getTokenStart() >= chunk.end) {
+            chunk.next_start = scanner.getTokenStart();
+            chunk.resume_pos = resume;
+            return;
+        }
+        appendToken(chunk, scanner, tok, source.data());
+        if (tok.type == T_EOF) {
+            chunk.next_start = SIZE_MAX;
+            chunk.resume_pos = scanner.getUK();
+            return;
+        }
+    }
+}
+
+// Точка перезапуска около pos: начало следующей строки. Комментарий "//"
+// всегда заканчивается на '\n', поэтому начало строки не бывает внутри
+// комментария. Внутри символьной константы оно оказаться может ('<перевод строки>'),
+// поэтому строки рядом с кавычкой пропускаются; редкие оставшиеся ошибки
+// догадки исправляет синхронизация при склейке.
+size_t findRestartPoint(std::string_view source, size_t pos) {
+    const char* begin = source.data();
+    const char* end = begin + source.length();
+    const char* p = begin + pos;
+    while (p < end) {
+        p = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (p == nullptr) return source.length();
+        bool quote_before = (p > begin && (p[-1] == '\'' || p[-1] == '\\'));
+        bool quote_after = (p + 1 < end && p[1] == '\'');
+        p++;
+        if (!quote_before && !quote_after) return static_cast<size_t>(p - begin);
+    }
+    return source.length();
+}
+
+} // namespace
+
+TokenBuffer::TokenBuffer(std::string_view source, unsigned threads, bool utf8)
+    : source_code(source), source_map(source) {
+    if (source.length() > UINT32_MAX) {
+        throw std::runtime_error("Файл слишком велик для буфера лексем (больше 4 ГБ).");
+    }
+
+    // Куски меньше этого размера не окупают запуск потока
+    const size_t MIN_CHUNK_SIZE = 64 * 1024;
+    size_t chunk_count = std::max<size_t>(1, std::min<size_t>(threads, source.length() / MIN_CHUNK_SIZE));
+
+    std::vector<TokenChunk> chunks(chunk_count);
+    size_t prev = 0;
+    for (size_t i = 0; i < chunk_count; ++i) {
+        chunks[i].begin = prev;
+        size_t boundary = (i + 1 == chunk_count)
+                              ? SIZE_MAX
+                              : std::max(prev, findRestartPoint(source, source.length() / chunk_count * (i + 1)));
+        chunks[i].end = boundary;
+        prev = boundary;
+    }
+
+    if (chunk_count == 1) {
+        lexChunk(source, utf8, chunks[0]);
+    } else {
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < chunk_count; ++i) {
+            workers.emplace_back(lexChunk, source, utf8, std::ref(chunks[i]));
+        }
+        lexChunk(source, utf8, chunks[0]);
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    // Склейка. Лексема полностью определяется позицией своего начала (у сканера
+    // нет другого состояния), поэтому если настоящий поток лексем и кусок,
+    // разобранный с догадки, содержат лексему с одним и тем же началом, дальше
+    // они совпадают. Настоящий поток продолжается последовательно до такой
+    // лексемы; обычно это первая же лексема следующего куска.
+    types = std::move(chunks[0].types);
+    offsets = std::move(chunks[0].offsets);
+    lengths = std::move(chunks[0].lengths);
+    size_t next_start = chunks[0].next_start;
+    size_t resume_pos = chunks[0].resume_pos;
+
+    for (size_t i = 1; i < chunk_count; ++i) {
+        TokenChunk& chunk = chunks[i];
+        auto sync = std::lower_bound(chunk.offsets.begin(), chunk.offsets.end(), next_start);
+        if (sync == chunk.offsets.end() || *sync != next_start) {
+            // Догадка неверна: продолжаем настоящий поток, пока он не сойдётся с куском
+            // или не выйдет за его границу
+            resynced_chunks++;
+            Scanner scanner(source, nullptr, utf8); // Потоки не трогают общую таблицу атомов
+            scanner.putUK(resume_pos);
+            TokenChunk tail;
+            bool replaced = false;
+            while (true) {
+                size_t resume = scanner.getUK();
+                Token tok = scanner.getNextToken();
+                size_t start = scanner.getTokenStart();
+                if (start >= chunk.end) {
+                    next_start = start;
+                    resume_pos = resume;
+                    replaced = true;
+                    break;
+                }
+                sync = std::lower_bound(chunk.offsets.begin(), chunk.offsets.end(), start);
+                if (sync != chunk.offsets.end() && *sync == start) break;
+                appendToken(tail, scanner, tok, source.data());
+            }
+            types.insert(types.end(), tail.types.begin(), tail.types.end());
+            offsets.insert(offsets.end(), tail.offsets.begin(), tail.offsets.end());
+            lengths.insert(lengths.end(), tail.lengths.begin(), tail.lengths.end());
+            if (replaced) continue; // Кусок целиком заменён настоящим потоком
+        }
+        size_t from = static_cast<size_t>(sync - chunk.offsets.begin());
+        types.insert(types.end(), chunk.types.begin() + from, chunk.types.end());
+        offsets.insert(offsets.end(), chunk.offsets.begin() + from, chunk.offsets.end());
+        lengths.insert(lengths.end(), chunk.lengths.begin() + from, chunk.lengths.end());
+        next_start = chunk.next_start;
+        resume_pos = chunk.resume_pos;
+    }
+}
+
+size_t TokenBuffer::size() const {
+    return types.size();
+}
+
+TokenType TokenBuffer::type(size_t index) const {
+    return static_cast<TokenType>(types[index]);
+}
+
+uint32_t TokenBuffer::offset(size_t index) const {
+    return offsets[index];
+}
+
+uint32_t TokenBuffer::length(size_t index) const {
+    return lengths[index];
+}
+
+std::string_view TokenBuffer::text(size_t index) const {
+    uint32_t off = offsets[index];
+    uint32_t len = lengths[index];
+    switch (type(index)) {
+        case T_EOF:
+            return "EOF";
+        case T_CHAR_CONST:
+            // Значение - символ перед закрывающей кавычкой
+            return source_code.substr(off + len - 2, 1);
+        case T_ERROR:
+            if (source_code[off] == '\'') return "Unclosed char literal";
+            return source_code.substr(off, len);
+        default:
+            return source_code.substr(off, len);
+    }
+}
+
+Token TokenBuffer::token(size_t index) const {
+    TokenType t = type(index);
+    std::string_view name = text(index);
+    // Имена интернируются при выдаче лексемы, в потоке парсера
+    Atom atom = (t == T_IDENT || t == T_MAIN) ? atom_table.intern(name) : ATOM_NONE;
+    Token tok = {t, name, offsets[index], atom};
+    // Значения констант вычисляются заново по тексту; диапазон уже проверил сканер
+    decodeLiteral(tok, source_code.substr(offsets[index], lengths[index]));
+    return tok;
+}
+
+const SourceMap& TokenBuffer::getSourceMap() const {
+    return source_map;
+}
+
+size_t TokenBuffer::getResyncedChunks() const {
+    return resynced_chunks;
+}
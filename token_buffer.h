@@ -0,0 +1,41 @@
+#ifndef TOKEN_BUFFER_H
+#define TOKEN_BUFFER_H
+
+#include "scanner.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Буфер лексем всего файла в виде параллельных массивов (struct-of-arrays):
+// 1 байт типа, 32-битное смещение и 32-битная длина на лексему.
+// Весь вход разбирается сканером один раз; парсер ходит по буферу по индексу.
+// Большой вход можно разбирать параллельно: он режется на куски по началам
+// строк, куски разбираются в отдельных потоках и склеиваются по порядку;
+// результат совпадает с последовательным разбором.
+// Позиция лексемы - её смещение; строка:столбец - через getSourceMap().
+class TokenBuffer {
+public:
+    // Лексический разбор всего входа до T_EOF включительно в threads потоках;
+    // utf8 - как у Scanner (вход уже проверен)
+    explicit TokenBuffer(std::string_view source, unsigned threads = 1, bool utf8 = false);
+
+    size_t size() const;
+    TokenType type(size_t index) const;
+    uint32_t offset(size_t index) const;
+    uint32_t length(size_t index) const;
+
+    std::string_view text(size_t index) const; // Текст лексемы, как его выдал сканер
+    Token token(size_t index) const;            // Лексема целиком
+    const SourceMap& getSourceMap() const;
+    size_t getResyncedChunks() const;           // Сколько кусков пришлось досинхронизировать
+
+private:
+    std::string_view source_code;
+    std::vector<uint8_t> types;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> lengths;
+    SourceMap source_map;
+    size_t resynced_chunks = 0;
+};
+
+#endif // TOKEN_BUFFER_H
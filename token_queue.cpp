@@ -0,0 +1,123 @@
+#include "token_queue.h"
+#include <iomanip>
+#include <stdexcept>
+
+const size_t TOKEN_QUEUE_MASK = TOKEN_QUEUE_SIZE - 1;
+static_assert((TOKEN_QUEUE_SIZE & TOKEN_QUEUE_MASK) == 0, "Размер кольца лексем - не степень двойки");
+
+const size_t OCCUPANCY_SAMPLE_PERIOD = 64; // Заполненность измеряется на каждой 64-й лексеме
+
+TokenQueue::TokenQueue(std::string_view source, bool utf8)
+    : scanner(source, nullptr, utf8), ring(new Token[TOKEN_QUEUE_SIZE]),
+      head(0), cached_tail(0), eof_seen(false), last_token(), pops(0),
+      occupancy_sum(0), occupancy_samples(0), consumer_waits(0),
+      tail(0), cached_head(0), producer_waits(0),
+      finished(false), stop(false) {
+    producer = std::thread(&TokenQueue::produce, this);
+}
+
+TokenQueue::~TokenQueue() {
+    stop.store(true, std::memory_order_relaxed);
+    producer.join();
+}
+
+// --- Сторона производителя ---
+
+void TokenQueue::produce() {
+    try {
+        while (true) {
+            Token token = scanner.getNextToken();
+            if (!push(token) || token.type == T_EOF) break;
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+    finished.store(true, std::memory_order_release);
+}
+
+bool TokenQueue::push(const Token& token) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - cached_head == TOKEN_QUEUE_SIZE) {
+        cached_head = head.load(std::memory_order_acquire);
+        while (t - cached_head == TOKEN_QUEUE_SIZE) {
+            producer_waits++;
+            if (stop.load(std::memory_order_relaxed)) return false;
+            std::this_thread::yield();
+            cached_head = head.load(std::memory_order_acquire);
+        }
+    }
+    ring[t & TOKEN_QUEUE_MASK] = token;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+// --- Сторона потребителя ---
+
+Token TokenQueue::pop() {
+    if (eof_seen) return last_token;
+
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == cached_tail) {
+        cached_tail = tail.load(std::memory_order_acquire);
+        while (h == cached_tail) {
+            if (finished.load(std::memory_order_acquire)) {
+                cached_tail = tail.load(std::memory_order_acquire);
+                if (h != cached_tail) break;
+                // Производитель завершился, не выдав T_EOF: только из-за исключения
+                if (error) std::rethrow_exception(error);
+                throw std::logic_error("Сканер остановился без лексемы EOF");
+            }
+            consumer_waits++;
+            std::this_thread::yield();
+            cached_tail = tail.load(std::memory_order_acquire);
+        }
+    }
+
+    if (pops++ % OCCUPANCY_SAMPLE_PERIOD == 0) {
+        occupancy_sum += tail.load(std::memory_order_relaxed) - h;
+        occupancy_samples++;
+    }
+
+    Token token = ring[h & TOKEN_QUEUE_MASK];
+    head.store(h + 1, std::memory_order_release);
+
+    if (token.type == T_IDENT || token.type == T_MAIN) {
+        token.atom = atom_table.intern(token.text);
+    }
+    if (token.type == T_EOF) {
+        eof_seen = true;
+        last_token = token;
+    }
+    return token;
+}
+
+const SourceMap& TokenQueue::getSourceMap() const {
+    return scanner.getSourceMap();
+}
+
+// --- Статистика ---
+
+size_t TokenQueue::getTokenCount() const {
+    return pops;
+}
+
+double TokenQueue::getAverageOccupancy() const {
+    return occupancy_samples == 0 ? 0.0 : double(occupancy_sum) / occupancy_samples;
+}
+
+size_t TokenQueue::getProducerWaits() const {
+    // Читается после T_EOF: производитель уже не пишет счётчик
+    return producer_waits;
+}
+
+size_t TokenQueue::getConsumerWaits() const {
+    return consumer_waits;
+}
+
+void TokenQueue::printStats(std::ostream& out) const {
+    out << "Pipeline: " << getTokenCount() << " tokens, queue occupancy "
+        << std::fixed << std::setprecision(1) << getAverageOccupancy() << "/" << TOKEN_QUEUE_SIZE
+        << " on average, scanner waited " << getProducerWaits()
+        << " times (queue full), parser waited " << getConsumerWaits()
+        << " times (queue empty)" << std::endl;
+}
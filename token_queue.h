@@ -0,0 +1,70 @@
+#ifndef TOKEN_QUEUE_H
+#define TOKEN_QUEUE_H
+
+#include "scanner.h"
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <ostream>
+#include <string_view>
+#include <thread>
+
+const size_t TOKEN_QUEUE_SIZE = 4096; // Ёмкость кольца лексем (степень двойки)
+
+// Конвейер "сканер -> парсер": сканер работает в отдельном потоке-производителе
+// и складывает лексемы в ограниченное кольцо без блокировок (один писатель,
+// один читатель), парсер забирает их через pop().
+// Полное кольцо останавливает сканер (обратное давление), пустое - парсер.
+// Исключение сканера передаётся через кольцо и повторно бросается в pop().
+// Вход - буфер в памяти: текст лексем ссылается на него и не зависит от
+// того, насколько сканер ушёл вперёд. Имена интернируются в потоке парсера.
+class TokenQueue {
+public:
+    explicit TokenQueue(std::string_view source, bool utf8 = false);
+    ~TokenQueue(); // Останавливает и дожидается производителя
+
+    TokenQueue(const TokenQueue&) = delete;
+    TokenQueue& operator=(const TokenQueue&) = delete;
+
+    Token pop(); // Следующая лексема; после T_EOF снова выдаётся T_EOF
+    const SourceMap& getSourceMap() const;
+
+    // Статистика заполненности: кто кого ждал
+    size_t getTokenCount() const;
+    double getAverageOccupancy() const;  // Средняя заполненность кольца при чтении
+    size_t getProducerWaits() const;     // Кольцо было полным - узкое место парсер
+    size_t getConsumerWaits() const;     // Кольцо было пустым - узкое место сканер
+    void printStats(std::ostream& out) const;
+
+private:
+    Scanner scanner;
+    std::unique_ptr<Token[]> ring;
+
+    // Позиции растут неограниченно, индекс в кольце - позиция & (размер - 1).
+    // Каждая сторона держит копию чужой позиции и перечитывает её только
+    // когда кольцо кажется полным/пустым.
+    alignas(64) std::atomic<size_t> head; // Читатель (парсер)
+    size_t cached_tail;
+    bool eof_seen;
+    Token last_token;
+    size_t pops;
+    size_t occupancy_sum;
+    size_t occupancy_samples;
+    size_t consumer_waits;
+
+    alignas(64) std::atomic<size_t> tail; // Писатель (сканер)
+    size_t cached_head;
+    size_t producer_waits;
+
+    alignas(64) std::atomic<bool> finished; // Производитель завершился
+    std::atomic<bool> stop;                 // Читатель больше не ждёт лексем
+    std::exception_ptr error;               // Исключение сканера (читать после finished)
+
+    std::thread producer;
+
+    void produce();
+    bool push(const Token& token); // false - читатель остановил конвейер
+};
+
+#endif // TOKEN_QUEUE_H
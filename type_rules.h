@@ -0,0 +1,119 @@
+#ifndef TYPE_RULES_H
+#define TYPE_RULES_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "scanner.h"
+#include "semantic.h"
+
+// Правила типизации в виде таблиц, которые строит компилятор. Проверки
+// бинарных операций, присваиваний и аргументов вызова (SemanticAnalyzer,
+// Parser::checkArgument) только читают отсюда по одному элементу, поэтому
+// правило меняется в одном месте - в makeBinaryRules или makeConversions.
+// Операнд типа TYPE_UNDEFINED (ошибка в нём уже сообщена) новых ошибок не
+// даёт - это тоже строки таблиц.
+
+const size_t TYPE_RULE_OPERATORS = T_ERROR + 1;
+const size_t TYPE_RULE_TYPES = TYPE_VOID + 1;
+
+// Результат бинарной операции над типами операндов
+struct BinaryRule {
+    uint8_t result;  // DataType результата
+    bool error;      // Операция не применима: сообщить об ошибке
+};
+
+typedef std::array<std::array<std::array<BinaryRule, TYPE_RULE_TYPES>, TYPE_RULE_TYPES>, TYPE_RULE_OPERATORS> BinaryRuleTable;
+
+// Преобразование значения к типу переменной или параметра
+enum Conversion : uint8_t {
+    CONV_OK,           // Без сообщений
+    CONV_NARROWING,    // Предупреждение о возможной потере данных
+    CONV_INCOMPATIBLE  // Ошибка
+};
+
+// Где преобразуется значение
+enum ConversionSite : uint8_t {
+    SITE_ASSIGN,    // Присваивание и инициализация: целое расширяется до double
+    SITE_ARGUMENT,  // Аргумент вызова: тип должен совпадать с типом параметра
+    SITE_COUNT
+};
+
+// [место][тип назначения][тип значения]
+typedef std::array<std::array<std::array<Conversion, TYPE_RULE_TYPES>, TYPE_RULE_TYPES>, SITE_COUNT> ConversionTable;
+
+constexpr bool isIntegerFamily(DataType type) {
+    return type == TYPE_INT || type == TYPE_SHORT || type == TYPE_LONG || type == TYPE_CHAR;
+}
+
+constexpr bool isNumeric(DataType type) {
+    return isIntegerFamily(type) || type == TYPE_DOUBLE;
+}
+
+constexpr BinaryRule binaryTypeRule(TokenType op, DataType left, DataType right) {
+    if (left == TYPE_UNDEFINED || right == TYPE_UNDEFINED) return {TYPE_UNDEFINED, false};
+    bool integers = isIntegerFamily(left) && isIntegerFamily(right);
+    switch (op) {
+        // Арифметические операции: double, если он есть среди операндов
+        // (упрощённо, даже при операнде void), иначе int для всех целых
+        case T_PLUS: case T_MINUS: case T_MUL: case T_DIV:
+            if (left == TYPE_DOUBLE || right == TYPE_DOUBLE) return {TYPE_DOUBLE, false};
+            if (integers) return {TYPE_INT, false};
+            break;
+        // Остаток и побитовые операции - только над целыми
+        case T_MOD:
+        case T_BIT_OR: case T_BIT_XOR: case T_BIT_AND: case T_LSHIFT: case T_RSHIFT:
+            if (integers) return {TYPE_INT, false};
+            break;
+        // Сравнивать можно любые числовые типы; результат - логический (int)
+        case T_EQ: case T_NE: case T_LT: case T_LE: case T_GT: case T_GE:
+            if (isNumeric(left) && isNumeric(right)) return {TYPE_INT, false};
+            break;
+        default:
+            break;
+    }
+    return {TYPE_UNDEFINED, true};
+}
+
+constexpr BinaryRuleTable makeBinaryRules() {
+    BinaryRuleTable t{};
+    for (size_t op = 0; op < TYPE_RULE_OPERATORS; ++op) {
+        for (size_t l = 0; l < TYPE_RULE_TYPES; ++l) {
+            for (size_t r = 0; r < TYPE_RULE_TYPES; ++r) {
+                t[op][l][r] = binaryTypeRule(static_cast<TokenType>(op), static_cast<DataType>(l), static_cast<DataType>(r));
+            }
+        }
+    }
+    return t;
+}
+
+constexpr Conversion conversionRule(ConversionSite site, DataType to, DataType from) {
+    if (to == from || from == TYPE_UNDEFINED) return CONV_OK;
+    if (site == SITE_ARGUMENT) return CONV_INCOMPATIBLE;
+    if (to == TYPE_DOUBLE && isIntegerFamily(from)) return CONV_OK;
+    if (isIntegerFamily(to) && from == TYPE_DOUBLE) return CONV_NARROWING;
+    return CONV_INCOMPATIBLE;
+}
+
+constexpr ConversionTable makeConversions() {
+    ConversionTable t{};
+    for (size_t s = 0; s < SITE_COUNT; ++s) {
+        for (size_t to = 0; to < TYPE_RULE_TYPES; ++to) {
+            for (size_t from = 0; from < TYPE_RULE_TYPES; ++from) {
+                t[s][to][from] = conversionRule(static_cast<ConversionSite>(s), static_cast<DataType>(to), static_cast<DataType>(from));
+            }
+        }
+    }
+    return t;
+}
+
+constexpr BinaryRuleTable binary_rules = makeBinaryRules();
+constexpr ConversionTable conversions = makeConversions();
+
+static_assert(binary_rules[T_LT][TYPE_CHAR][TYPE_DOUBLE].result == TYPE_INT, "Сравнение даёт int");
+static_assert(binary_rules[T_MOD][TYPE_DOUBLE][TYPE_INT].error, "Остаток от double не определён");
+static_assert(!binary_rules[T_ASSIGN][TYPE_UNDEFINED][TYPE_INT].error, "Ошибочный операнд не даёт новых ошибок");
+static_assert(conversions[SITE_ASSIGN][TYPE_SHORT][TYPE_DOUBLE] == CONV_NARROWING, "double -> целое сужает");
+static_assert(conversions[SITE_ARGUMENT][TYPE_DOUBLE][TYPE_INT] == CONV_INCOMPATIBLE, "Аргумент не преобразуется");
+
+#endif // TYPE_RULES_H
@@ -0,0 +1,27 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Поддержка исходников в UTF-8: проверка корректности входа, декодирование
+// символа и классы символов идентификаторов XID_Start / XID_Continue.
+
+// Первый байт некорректной (или обрезанной концом буфера) последовательности
+// в [p, end); end - весь буфер корректен. Серии ASCII проверяются векторно.
+const char* validateUtf8(const char* p, const char* end);
+// [p, end) - корректное, но неполное начало многобайтовой последовательности
+// (в потоковом режиме её конец ещё не прочитан)
+bool isTruncatedUtf8(const char* p, const char* end);
+// Декодирование символа с p в *cp; возвращает его длину в байтах
+// (0 - последовательность не помещается в [p, end)). Вход должен быть проверен.
+size_t decodeUtf8(const char* p, const char* end, uint32_t* cp);
+
+// Проверка всего буфера; при ошибке - исключение с позицией первого неверного байта
+void requireValidUtf8(std::string_view text);
+
+bool isXidStart(uint32_t cp);
+bool isXidContinue(uint32_t cp);
+
+#endif // UTF8_H
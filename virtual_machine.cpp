@@ -0,0 +1,183 @@
+#include "virtual_machine.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Целые операции считаются в 64 битах по модулю 2^64 (без неопределённого
+// поведения при переполнении), результат имеет тип int
+int64_t toInt32(uint64_t value) {
+    return static_cast<int32_t>(static_cast<uint32_t>(value));
+}
+
+int64_t narrow(int64_t value, DataType type) {
+    switch (type) {
+        case TYPE_CHAR: return static_cast<int8_t>(static_cast<uint8_t>(value));
+        case TYPE_SHORT: return static_cast<int16_t>(static_cast<uint16_t>(value));
+        case TYPE_INT: return toInt32(static_cast<uint64_t>(value));
+        default: return value;
+    }
+}
+
+// Отбрасывание дробной части с насыщением (NaN - ноль)
+int64_t doubleToInt(double value) {
+    if (std::isnan(value)) return 0;
+    if (value >= 9223372036854775807.0) return INT64_MAX;
+    if (value <= -9223372036854775808.0) return INT64_MIN;
+    return static_cast<int64_t>(value);
+}
+
+} // namespace
+
+VirtualMachine::VirtualMachine(const Bytecode& bytecode)
+    : bytecode(bytecode), globals(bytecode.globals.size()) {
+    for (Value& v : globals) v.i = 0;
+}
+
+void VirtualMachine::run() {
+    const std::vector<Instruction>& code = bytecode.code;
+    size_t base = 0;
+    uint32_t ip = 0;
+    while (true) {
+        const Instruction& in = code[ip++];
+        switch (in.op) {
+            case OP_PUSH_INT: {
+                Value v;
+                v.i = in.arg;
+                stack.push_back(v);
+                break;
+            }
+            case OP_PUSH_DOUBLE: {
+                Value v;
+                v.d = bytecode.doubles[in.arg];
+                stack.push_back(v);
+                break;
+            }
+            case OP_LOAD_GLOBAL: stack.push_back(globals[in.arg]); break;
+            case OP_STORE_GLOBAL: globals[in.arg] = stack.back(); stack.pop_back(); break;
+            case OP_LOAD_LOCAL: stack.push_back(stack[base + in.arg]); break;
+            case OP_STORE_LOCAL: stack[base + in.arg] = stack.back(); stack.pop_back(); break;
+            case OP_CLEAR_LOCAL: stack[base + in.arg].i = 0; break;
+            case OP_POP: stack.pop_back(); break;
+
+            case OP_INT_TO_DOUBLE: stack.back().d = static_cast<double>(stack.back().i); break;
+            case OP_INT_TO_DOUBLE_UNDER: {
+                Value& v = stack[stack.size() - 2];
+                v.d = static_cast<double>(v.i);
+                break;
+            }
+            case OP_DOUBLE_TO_INT: stack.back().i = doubleToInt(stack.back().d); break;
+            case OP_NARROW: stack.back().i = narrow(stack.back().i, static_cast<DataType>(in.arg)); break;
+            case OP_TEST_DOUBLE: stack.back().i = stack.back().d != 0.0; break;
+            case OP_NEG_I: stack.back().i = static_cast<int64_t>(0 - static_cast<uint64_t>(stack.back().i)); break;
+            case OP_NEG_D: stack.back().d = -stack.back().d; break;
+
+            case OP_ADD_I: case OP_SUB_I: case OP_MUL_I: case OP_DIV_I: case OP_MOD_I:
+            case OP_SHL: case OP_SHR: case OP_AND: case OP_OR: case OP_XOR:
+            case OP_EQ_I: case OP_NE_I: case OP_LT_I: case OP_LE_I: case OP_GT_I: case OP_GE_I: {
+                int64_t b = stack.back().i;
+                stack.pop_back();
+                int64_t a = stack.back().i;
+                uint64_t ua = static_cast<uint64_t>(a), ub = static_cast<uint64_t>(b);
+                int64_t r = 0;
+                switch (in.op) {
+                    case OP_ADD_I: r = toInt32(ua + ub); break;
+                    case OP_SUB_I: r = toInt32(ua - ub); break;
+                    case OP_MUL_I: r = toInt32(ua * ub); break;
+                    case OP_DIV_I:
+                    case OP_MOD_I:
+                        if (b == 0) throw std::runtime_error("Ошибка выполнения: деление на ноль.");
+                        if (b == -1) { // INT64_MIN / -1 не представимо
+                            r = in.op == OP_DIV_I ? toInt32(0 - ua) : 0;
+                        } else {
+                            r = toInt32(static_cast<uint64_t>(in.op == OP_DIV_I ? a / b : a % b));
+                        }
+                        break;
+                    case OP_SHL: r = toInt32(ua << (b & 63)); break;
+                    case OP_SHR: r = toInt32(static_cast<uint64_t>(a >> (b & 63))); break;
+                    case OP_AND: r = toInt32(ua & ub); break;
+                    case OP_OR: r = toInt32(ua | ub); break;
+                    case OP_XOR: r = toInt32(ua ^ ub); break;
+                    case OP_EQ_I: r = a == b; break;
+                    case OP_NE_I: r = a != b; break;
+                    case OP_LT_I: r = a < b; break;
+                    case OP_LE_I: r = a <= b; break;
+                    case OP_GT_I: r = a > b; break;
+                    default: r = a >= b; break;
+                }
+                stack.back().i = r;
+                break;
+            }
+            case OP_ADD_D: case OP_SUB_D: case OP_MUL_D: case OP_DIV_D: {
+                double b = stack.back().d;
+                stack.pop_back();
+                double& a = stack.back().d;
+                switch (in.op) {
+                    case OP_ADD_D: a += b; break;
+                    case OP_SUB_D: a -= b; break;
+                    case OP_MUL_D: a *= b; break;
+                    default: a /= b; break;
+                }
+                break;
+            }
+            case OP_EQ_D: case OP_NE_D: case OP_LT_D: case OP_LE_D: case OP_GT_D: case OP_GE_D: {
+                double b = stack.back().d;
+                stack.pop_back();
+                double a = stack.back().d;
+                int64_t r;
+                switch (in.op) {
+                    case OP_EQ_D: r = a == b; break;
+                    case OP_NE_D: r = a != b; break;
+                    case OP_LT_D: r = a < b; break;
+                    case OP_LE_D: r = a <= b; break;
+                    case OP_GT_D: r = a > b; break;
+                    default: r = a >= b; break;
+                }
+                stack.back().i = r;
+                break;
+            }
+
+            case OP_JUMP: ip = static_cast<uint32_t>(in.arg); break;
+            case OP_JUMP_IF_FALSE: {
+                int64_t cond = stack.back().i;
+                stack.pop_back();
+                if (cond == 0) ip = static_cast<uint32_t>(in.arg);
+                break;
+            }
+            case OP_CALL: {
+                if (frames.size() >= VM_MAX_CALL_DEPTH) {
+                    throw std::runtime_error("Ошибка выполнения: слишком глубокая рекурсия.");
+                }
+                const BytecodeFunction& f = bytecode.functions[in.arg];
+                frames.push_back({ip, base});
+                base = stack.size() - f.param_count;
+                Value zero;
+                zero.i = 0;
+                stack.resize(base + f.frame_size, zero);
+                ip = f.entry;
+                break;
+            }
+            case OP_RETURN:
+                stack.resize(base);
+                ip = frames.back().return_ip;
+                base = frames.back().base;
+                frames.pop_back();
+                break;
+            case OP_HALT:
+                return;
+        }
+    }
+}
+
+void VirtualMachine::printGlobals(std::ostream& out) const {
+    for (size_t i = 0; i < globals.size(); ++i) {
+        const BytecodeGlobal& g = bytecode.globals[i];
+        out << atom_table.name(g.name) << " = ";
+        if (g.type == TYPE_DOUBLE) {
+            out << globals[i].d;
+        } else {
+            out << globals[i].i;
+        }
+        out << std::endl;
+    }
+}
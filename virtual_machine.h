@@ -0,0 +1,39 @@
+#ifndef VIRTUAL_MACHINE_H
+#define VIRTUAL_MACHINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "bytecode.h"
+
+const size_t VM_MAX_CALL_DEPTH = 1 << 16;
+
+// Интерпретатор байт-кода. Ошибки выполнения (деление на ноль, слишком
+// глубокая рекурсия) бросают std::runtime_error.
+class VirtualMachine {
+public:
+    explicit VirtualMachine(const Bytecode& bytecode);
+
+    void run();
+    // Значения глобальных переменных после run(): у языка нет вывода, поэтому
+    // результат программы - её глобальные переменные
+    void printGlobals(std::ostream& out) const;
+
+private:
+    union Value {
+        int64_t i;
+        double d;
+    };
+    struct Frame {
+        uint32_t return_ip;
+        size_t base;         // Начало кадра на стеке значений
+    };
+
+    const Bytecode& bytecode;
+    std::vector<Value> globals;
+    std::vector<Value> stack;
+    std::vector<Frame> frames;
+};
+
+#endif // VIRTUAL_MACHINE_H